@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "Katagrafeas.hpp"
+#include "Chronometro.hpp"
+
+// throughput of the Katagrafeas hot paths
+// usage: Bench [max threads] [lines per thread]
+
+namespace
+{
+  // discards every line, only the cost of producing them remains
+  class NullSink final : public ktz::Sink
+  {
+  public:
+    void write(const char*, size_t) noexcept override {}
+  };
+
+  template<typename F>
+  void run(const char* const path_, const char* const sink_, const unsigned threads_, const unsigned lines_, F body_)
+  {
+    std::vector<std::thread> workers;
+    workers.reserve(threads_);
+
+    chz::Stopwatch stopwatch;
+
+    for (unsigned k = 0; k < threads_; ++k)
+    {
+      workers.emplace_back([&]{
+        for (unsigned line = 0; line < lines_; ++line)
+        {
+          body_(line);
+        }
+      });
+    }
+
+    for (auto& worker : workers)
+    {
+      worker.join();
+    }
+
+    const auto elapsed = static_cast<double>(stopwatch.total().nanoseconds.count());
+    const auto lines   = static_cast<double>(threads_)*lines_;
+
+    std::printf("%-20s %-5s %7u %10.1f %14.0f\n", path_, sink_, threads_, elapsed/lines, lines*1e9/elapsed);
+  }
+
+  void bench(ktz::Logger& logger_, const char* const sink_, const unsigned threads_, const unsigned lines_)
+  {
+    std::ostream library(nullptr);
+
+    run("Logger <<", sink_, threads_, lines_, [&](unsigned line_){
+      logger_ << "message " << line_ << '\n';
+    });
+
+    logger_.link(library, "[library] ");
+    run("linked", sink_, threads_, lines_, [&](unsigned line_){
+      library << "message " << line_ << '\n';
+    });
+    logger_.restore(library);
+
+    logger_.link(library, "[%H:%M:%S] [library] ");
+    run("linked, time prefix", sink_, threads_, lines_, [&](unsigned line_){
+      library << "message " << line_ << '\n';
+    });
+    logger_.restore(library);
+
+    logger_.link(ktz::_io::log);
+    run("log_message", sink_, threads_, lines_, [](unsigned line_){
+      ktz::log_message("message %u", line_);
+    });
+
+    run("indented_log", sink_, threads_, lines_, [](unsigned line_){
+      ktz::indented_log("message %u", line_);
+    });
+    logger_.restore(ktz::_io::log);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned max_threads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1]))
+                             : std::max(std::thread::hardware_concurrency(), 1U);
+  const unsigned lines       = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 200000;
+
+  std::printf("%-20s %-5s %7s %10s %14s\n", "path", "sink", "threads", "ns/line", "lines/sec");
+
+  for (unsigned threads = 1; threads and threads <= max_threads; threads = threads < max_threads
+    ? std::min(2*threads, max_threads) : 0)
+  {
+    {
+      NullSink    sink;
+      ktz::Logger logger(sink);
+      bench(logger, "null", threads, lines);
+    }
+
+    {
+      std::ofstream file("bench.log", std::ios::trunc);
+      ktz::Logger   logger(file);
+      bench(logger, "file", threads, lines);
+    }
+
+    {
+      ktz::RawFile file("bench.log");
+      ktz::Logger  logger(file);
+      bench(logger, "raw", threads, lines);
+    }
+  }
+
+  return 0;
+}
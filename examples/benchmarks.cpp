@@ -0,0 +1,52 @@
+#include <sstream>
+#include <string>
+#include "Katagrafeas.hpp"
+#include "Chronometro.hpp"
+
+// formatting costs of Katagrafeas, one benchmark binary for the component
+// usage: Benchmarks [--filter=TEXT] [--iterations=N] [--repetitions=N] [--warmup=N] [--format=console|csv|json]
+
+namespace
+{
+  // discards every line, only the cost of producing them remains
+  class NullSink final : public ktz::Sink
+  {
+  public:
+    void write(const char*, size_t) noexcept override {}
+  };
+
+  NullSink    sink;
+  ktz::Logger logger(sink);
+}
+
+CHZ_BENCHMARK(logger_text)
+{
+  for (auto iteration : measure)
+  {
+    static_cast<void>(iteration);
+    logger << "message\n";
+  }
+}
+
+CHZ_BENCHMARK(logger_integer)
+{
+  for (auto iteration : measure)
+  {
+    logger << "message " << iteration.value << '\n';
+  }
+}
+
+CHZ_BENCHMARK(ostringstream_integer)
+{
+  std::ostringstream stream;
+
+  for (auto iteration : measure)
+  {
+    stream << "message " << iteration.value << '\n';
+
+    const auto avoid = iteration.avoid();
+    stream.str(std::string());
+  }
+}
+
+CHZ_BENCHMARK_MAIN()
@@ -0,0 +1,28 @@
+#include <fstream>
+#include <iostream>
+#include "Katagrafeas.hpp"
+
+// render records written by ktz::dump_binary as text
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <dump>...\n";
+    return 1;
+  }
+
+  for (int k = 1; k < argc; ++k)
+  {
+    std::ifstream dump(argv[k], std::ios::binary);
+
+    if (not dump)
+    {
+      std::cerr << "error: could not open " << argv[k] << '\n';
+      return 1;
+    }
+
+    ktz::decode_binary(dump, std::cout);
+  }
+
+  return 0;
+}
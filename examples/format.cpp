@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <cstring>
+#include "Katagrafeas.hpp"
+
+// compare ktz formatting against the C library, prints the mismatches and fails if there are any
+
+namespace
+{
+  unsigned failures = 0;
+
+  template<typename... T>
+  void compare(const char* const format_, const T... args_)
+  {
+    ktz::_impl::_text actual;
+    ktz::_impl::_format(actual, format_, args_...);
+
+    char expected[512];
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    const int size = std::snprintf(expected, sizeof(expected), format_, args_...);
+#pragma GCC diagnostic pop
+
+    if (static_cast<size_t>(size) != actual.size() or std::memcmp(expected, actual.data(), actual.size()) != 0)
+    {
+      std::printf("%-10s ktz: \"%.*s\" printf: \"%s\"\n", format_, static_cast<int>(actual.size()), actual.data(),
+        expected);
+      ++failures;
+    }
+  }
+}
+
+int main()
+{
+  compare("%d", 0);
+  compare("%d", -1);
+  compare("%d", 2147483647);
+  compare("%+d", 42);
+  compare("% d", 42);
+  compare("%5d|%-5d|%05d", -42, -42, -42);
+  compare("%.3d", 7);
+  compare("%.0d", 0);
+  compare("%i", -2147483647 - 1);
+  compare("%u", 4294967295u);
+  compare("%u", -1);
+  compare("%x", -1);
+  compare("%X", 3054);
+  compare("%#x", 255);
+  compare("%#o", 8);
+  compare("%#o", 0);
+  compare("%#.0o", 0);
+  compare("%#.4o", 8);
+  compare("%o", -1);
+  compare("%hhd", 300);
+  compare("%hhd", 200);
+  compare("%hhu", -1);
+  compare("%hd", 70000);
+  compare("%hx", -1);
+  compare("%ld", -1L);
+  compare("%lx", -1L);
+  compare("%lld", -9223372036854775807LL - 1);
+  compare("%llu", 18446744073709551615ULL);
+  compare("%llx", -1LL);
+  compare("%zu", sizeof(long double));
+  compare("%c", 'k');
+  compare("%c", 65 + 256);
+  compare("%f", 3.14159265);
+  compare("%.0f", 0.5);
+  compare("%.0f", 1.5);
+  compare("%.0f", 2.5);
+  compare("%.0f", 3.5);
+  compare("%.0f", -3.5);
+  compare("%#.0f", 3.0);
+  compare("%.1f", 0.25);
+  compare("%.1f", 0.35);
+  compare("%.1f", 0.45);
+  compare("%.2f", 2.675);
+  compare("%.2f", 0.125);
+  compare("%.2f", 1.005);
+  compare("%.3f", -0.0005);
+  compare("%.9f", 1e-9);
+  compare("%10.2f|%-10.2f|%010.2f", 3.14159, 3.14159, -3.14159);
+  compare("%+.1f", 99.95);
+  compare("%e", 12345.678);
+  compare("%f", 1e300);
+  compare("%a", 0.1);
+  compare("%10a|%-12.2A", 0.1, -2.5);
+  compare("%.3g", 0.0001234);
+  compare("%s", "text");
+  compare("%8.3s|%-8s", "text", "text");
+
+  std::printf("%u mismatch%s\n", failures, failures == 1 ? "" : "es");
+
+  return failures ? 1 : 0;
+}
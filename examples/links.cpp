@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include "Katagrafeas.hpp"
+
+// restore links in every order, the ostream must end up with its original buffer and never reach a freed one
+
+namespace
+{
+  unsigned failures = 0;
+
+  void expect(const std::string& actual_, const char* const expected_, const char* const what_)
+  {
+    if (actual_ != expected_)
+    {
+      std::printf("%s: got \"%s\", expected \"%s\"\n", what_, actual_.c_str(), expected_);
+      ++failures;
+    }
+  }
+
+  // reclaiming a retired interceptor takes a later link or restore once this thread wrote again
+  void write_and_reclaim(ktz::Logger& logger_, std::ostream& stream_, const char* const text_)
+  {
+    stream_ << text_ << std::flush;
+    std::ostream other(nullptr);
+    logger_.restore(logger_.link(other));
+  }
+}
+
+int main()
+{
+  {
+    std::ostringstream original, logged;
+    std::ostream       stream(original.rdbuf());
+    ktz::Logger        logger(logged);
+
+    const auto older = logger.link(stream, "[1] ");
+    const auto newer = logger.link(stream, "[2] ");
+
+    logger.restore(older); // not the topmost link, the newer one inherits the original buffer
+    write_and_reclaim(logger, stream, "a\n");
+    logger.restore(newer);
+    write_and_reclaim(logger, stream, "b\n");
+
+    expect(logged.str(), "[2] a\n", "older first, logged");
+    expect(original.str(), "b\n", "older first, original");
+  }
+
+  {
+    std::ostringstream original, logged_1, logged_2;
+    std::ostream       stream(original.rdbuf());
+    ktz::Logger        logger_1(logged_1);
+    ktz::Logger        logger_2(logged_2);
+
+    const auto first  = logger_1.link(stream);
+    const auto second = logger_2.link(stream);
+    const auto third  = logger_1.link(stream);
+
+    logger_2.restore(second); // spliced across Loggers
+    write_and_reclaim(logger_2, stream, "a\n");
+    logger_1.restore(first);
+    write_and_reclaim(logger_1, stream, "b\n");
+    logger_1.restore(third);
+    write_and_reclaim(logger_1, stream, "c\n");
+
+    expect(logged_1.str(), "a\nb\n", "across Loggers, first Logger");
+    expect(logged_2.str(), "", "across Loggers, second Logger");
+    expect(original.str(), "c\n", "across Loggers, original");
+  }
+
+  {
+    std::ostringstream original, logged;
+    std::ostream       stream(original.rdbuf());
+    ktz::Logger        logger(logged);
+
+    const auto older = logger.link(stream);
+    const auto newer = logger.link(stream);
+
+    logger.restore(newer);
+    write_and_reclaim(logger, stream, "a\n");
+    logger.restore(older);
+    write_and_reclaim(logger, stream, "b\n");
+
+    expect(logged.str(), "a\n", "newer first, logged");
+    expect(original.str(), "b\n", "newer first, original");
+  }
+
+  std::printf("%u failure%s\n", failures, failures == 1 ? "" : "s");
+
+  return failures ? 1 : 0;
+}
@@ -48,10 +48,29 @@ execution time of code blocks and more. See the included README.MD file for more
 #include <string>   // for std::string, std::to_string
 #include <utility>  // for std::move
 #include <cstdio>   // for std::sprintf
+#include <memory>   // for std::unique_ptr
+#include <new>      // for std::nothrow
+#include <vector>   // for std::vector
+#include <algorithm> // for std::sort, std::nth_element, std::max_element, std::remove_if
+#include <cmath>    // for std::sqrt, std::ceil
+#include <cstring>  // for std::strcmp, std::strncmp, std::strstr, std::strlen
+#include <cstdlib>  // for std::strtoul
 //---conditionally necessary standard libraries-------------------------------------------------------------------------
 #if not defined(CHZ_CLOCK)
 # include <type_traits> // for std::conditional
 #endif
+#if not defined(__GNUC__)
+# include <atomic> // for std::atomic_signal_fence
+#endif
+#if defined(__x86_64__) or defined(__i386__) or defined(_M_X64) or defined(_M_IX86)
+# define _chz_impl_X86
+# if defined(_MSC_VER)
+#   include <intrin.h>    // for __rdtscp, __cpuid
+# else
+#   include <x86intrin.h> // for __rdtscp
+#   include <cpuid.h>     // for __get_cpuid
+# endif
+#endif
 #if defined(__STDCPP_THREADS__) and not defined(CHZ_NOT_THREADSAFE)
 # define  _chz_impl_THREADSAFE
 # include <mutex> // for std::mutex, std::lock_guard
@@ -68,6 +87,10 @@ namespace chz
   // measure iterations via range-based for-loop
   class Measure;
 
+  // rdtscp-based clock calibrated against std::chrono::steady_clock, which it falls back on without an invariant TSC
+  // use it for Stopwatch and Measure with: #define CHZ_CLOCK chz::tsc_clock
+  class tsc_clock;
+
   // units in which time obtained from Stopwatch can be displayed
   // and in which sleep() be slept with.
   enum class Unit
@@ -85,6 +108,13 @@ namespace chz
   template<Unit unit = Unit::ms>
   void sleep(unsigned long long amount) noexcept;
 
+  // keep 'value', and the computation producing it, from being optimized away
+  template<typename T>
+  void do_not_optimize(const T& value) noexcept;
+
+  inline // force pending writes to memory and reloads after it, without emitting an instruction
+  void clobber_memory() noexcept;
+
   // execute the following only if its last execution was atleast 'MS' milliseconds prior
 # define CHZ_ONLY_EVERY(MS)
 
@@ -94,6 +124,16 @@ namespace chz
   // break out of a loop when reached 'N' times
 # define CHZ_BREAK_AFTER(N)
 
+  // register a benchmark, its body measures iterations of 'measure': for (auto iteration : measure) {...}
+# define CHZ_BENCHMARK(NAME)
+
+  // main running the registered benchmarks, see run_benchmarks
+# define CHZ_BENCHMARK_MAIN()
+
+  // run the registered benchmarks according to the command line, return the exit status
+  // --filter=TEXT --iterations=N --budget=MS --repetitions=N --warmup=N --format=console|csv|json
+  inline int run_benchmarks(int argc, char* argv[]) noexcept;
+
   namespace _io
   {
     static std::ostream out(std::cout.rdbuf()); // output
@@ -347,6 +387,62 @@ namespace chz
       return _format_time(_time<unit, 3>{time_.nanoseconds/n_iters_}, std::move(fmt_));
     }
 
+    // sample at the 'percent' percentile of sorted samples, nearest-rank method
+    inline auto _percentile(const std::vector<long long>& sorted_, const double percent_) noexcept -> long long
+    {
+      const auto rank = static_cast<size_t>(std::ceil(percent_/100*static_cast<double>(sorted_.size())));
+      return sorted_[rank ? rank - 1 : 0];
+    }
+
+    // median of unsorted samples, reorders them
+    inline auto _median(std::vector<long long>& samples_) noexcept -> long long
+    {
+      const size_t middle = samples_.size()/2;
+      std::nth_element(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(middle), samples_.end());
+      const long long upper = samples_[middle];
+
+      if (samples_.size() % 2)
+      {
+        return upper;
+      }
+
+      const long long lower = *std::max_element(samples_.begin(), samples_.begin() + static_cast<std::ptrdiff_t>(middle));
+      return lower + (upper - lower)/2;
+    }
+
+    template<typename S>
+    auto _statistics_as_string(const S& statistics_) noexcept -> std::string
+    {
+      if (statistics_.calibrated)
+      {
+        return std::string("mean = ") + _time_as_cstring(_time<Unit::automatic, 3>{statistics_.mean});
+      }
+
+      const std::pair<const char*, std::chrono::nanoseconds> fields[] = {
+        {"min = ",      statistics_.min},
+        {", median = ", statistics_.median},
+        {", p90 = ",    statistics_.p90},
+        {", p99 = ",    statistics_.p99},
+        {", max = ",    statistics_.max},
+        {", stddev = ", statistics_.stddev},
+        {", MAD = ",    statistics_.mad}
+      };
+
+      std::string text;
+      for (const auto& field : fields)
+      {
+        text += field.first;
+        text += _time_as_cstring(_time<Unit::automatic, 3>{field.second});
+      }
+
+      if (statistics_.rejected)
+      {
+        text += " [" + std::to_string(statistics_.rejected) + " outliers rejected]";
+      }
+
+      return text;
+    }
+
     struct _backdoor;
   }
 //----------------------------------------------------------------------------------------------------------------------
@@ -357,6 +453,40 @@ namespace chz
     for (chz::Measure _chz_impl_MEASURE##LINE{__VA_ARGS__}; \
       chz::_impl::_backdoor::good(_chz_impl_MEASURE##LINE); \
       chz::_impl::_backdoor::next(_chz_impl_MEASURE##LINE))
+//----------------------------------------------------------------------------------------------------------------------
+  class tsc_clock final
+  {
+  public:
+    using duration   = std::chrono::nanoseconds;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<tsc_clock>;
+    static constexpr bool is_steady = true;
+
+    static inline // current time, nanoseconds since the epoch of std::chrono::steady_clock
+    auto now() noexcept -> time_point;
+
+    static inline // whether the TSC is read, otherwise std::chrono::steady_clock is
+    bool invariant() noexcept;
+
+  private:
+    struct _calibration
+    {
+      bool               invariant;
+      double             ns_per_tick;
+      unsigned long long origin_ticks;
+      duration           origin;
+    };
+
+    static inline // calibrated once, on first use
+    auto _calibrated() noexcept -> const _calibration&;
+
+    static inline // value of the time-stamp counter, ordered after all prior instructions
+    unsigned long long _ticks() noexcept;
+
+    static inline // the TSC runs at a constant rate across P-, C- and T-states, and rdtscp is available
+    bool _supported() noexcept;
+  };
 //----------------------------------------------------------------------------------------------------------------------
   class Stopwatch
   {
@@ -393,6 +523,22 @@ namespace chz
   {
     class Iteration;
   public:
+    // distribution of the iteration times
+    struct Statistics
+    {
+      bool                     calibrated; // measured against a budget, only 'samples' and 'mean' are set
+      unsigned                 samples;    // iterations kept
+      unsigned                 rejected; // iterations rejected as outliers
+      std::chrono::nanoseconds min;
+      std::chrono::nanoseconds max;
+      std::chrono::nanoseconds median;
+      std::chrono::nanoseconds p90;
+      std::chrono::nanoseconds p99;
+      std::chrono::nanoseconds mean;
+      std::chrono::nanoseconds stddev;
+      std::chrono::nanoseconds mad;      // median absolute deviation
+    };
+
     constexpr // measure one iteration
     Measure() noexcept = default;
 
@@ -411,6 +557,10 @@ namespace chz
     inline // measure iterations with custom total message
     Measure(const char* total_format, unsigned iterations) noexcept;
 
+    inline // grow the iteration count geometrically until a round of iterations lasts at least 'budget'
+    Measure(std::chrono::nanoseconds budget,
+      const char* total_format = "total elapsed time: %ms for %# iterations [avg = %Dns]") noexcept;
+
     inline // pause measurement
     void pause() noexcept;
 
@@ -420,12 +570,23 @@ namespace chz
     inline // scoped pause/start of measurement
     auto avoid() noexcept -> decltype(Stopwatch().avoid());
 
+    inline // leave iterations further than 'mads' median absolute deviations from the median out of the statistics
+    auto reject_outliers(double mads) noexcept -> Measure&;
+
+    inline // statistics of the iterations measured so far, "%S" in the total format prints them
+    auto statistics() const noexcept -> Statistics;
+
   private:
-    const unsigned    _iterations = 1;
+    unsigned          _iterations = 1;
     unsigned          _remaining  = _iterations;
     const char* const _split_fmt  = nullptr;
     const char* const _total_fmt  = "total elapsed time: %ms";
     Stopwatch         _stopwatch;
+    double            _outliers   = 0;       // rejection threshold in MADs, 0 keeps every iteration
+    unsigned          _recorded   = 0;       // iterations in _samples
+    std::unique_ptr<std::chrono::nanoseconds[]> _samples; // one split per iteration, allocated once
+    std::chrono::nanoseconds _budget = {}; // minimal duration of the measured round, zero for a fixed count
+    std::chrono::nanoseconds _round  = {}; // duration of the measured round
     class _iterator;
   public:
     inline auto begin()     noexcept -> _iterator;
@@ -447,6 +608,28 @@ namespace chz
   
   template<>
   void sleep<Unit::automatic>(unsigned long long) noexcept = delete;
+//----------------------------------------------------------------------------------------------------------------------
+  // the address escapes into an empty asm that may read or write any memory
+  template<typename T>
+  void do_not_optimize(const T& value_) noexcept
+  {
+# if defined(__GNUC__)
+    __asm__ __volatile__("" : : "r"(&value_) : "memory");
+# else
+    static const void* volatile escaped;
+    escaped = &value_;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+# endif
+  }
+
+  void clobber_memory() noexcept
+  {
+# if defined(__GNUC__)
+    __asm__ __volatile__("" : : : "memory");
+# else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+# endif
+  }
 //----------------------------------------------------------------------------------------------------------------------
 # undef  CHZ_ONLY_EVERY
 # define CHZ_ONLY_EVERY(MS)                  _chz_impl_ONLY_EVERY_PRXY(__LINE__, MS)
@@ -498,6 +681,9 @@ namespace chz
 
     inline // scoped pause/start of measurement
     auto avoid() noexcept -> decltype(Stopwatch().avoid());
+
+    template<typename T> // consume the result of the iteration so it cannot be optimized away
+    void sink(const T& result) const noexcept;
   private:
     inline Iteration(unsigned current_iteration, Measure* measurement) noexcept;
     Measure* const _measurement;
@@ -539,6 +725,101 @@ namespace chz
       _stopwatch->start();
     }
   };
+//----------------------------------------------------------------------------------------------------------------------
+  auto tsc_clock::now() noexcept -> time_point
+  {
+    const auto& calibration = _calibrated();
+
+    if _chz_impl_EXPECTED(calibration.invariant)
+    {
+      const auto ticks = static_cast<long long>(_ticks() - calibration.origin_ticks);
+      return time_point{calibration.origin + duration{static_cast<rep>(static_cast<double>(ticks)*calibration.ns_per_tick)}};
+    }
+
+    return time_point{std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch())};
+  }
+
+  bool tsc_clock::invariant() noexcept
+  {
+    return _calibrated().invariant;
+  }
+
+  auto tsc_clock::_calibrated() noexcept -> const _calibration&
+  {
+    static const _calibration calibration = []
+    {
+      _calibration result = {false, 0.0, 0, {}};
+
+      if _chz_impl_ABNORMAL(!_supported())
+      {
+        return result;
+      }
+
+      // long enough for the ~20 ns cost of steady_clock::now() to be well under a part per million
+      constexpr auto span = std::chrono::milliseconds{20};
+
+      const auto start_time  = std::chrono::steady_clock::now();
+      const auto start_ticks = _ticks();
+
+      auto stop_time = start_time;
+      while ((stop_time = std::chrono::steady_clock::now()) - start_time < span);
+      const auto stop_ticks = _ticks();
+
+      if _chz_impl_ABNORMAL(stop_ticks <= start_ticks)
+      {
+        return result;
+      }
+
+      const auto elapsed = std::chrono::duration_cast<duration>(stop_time - start_time);
+
+      result.invariant    = true;
+      result.ns_per_tick  = static_cast<double>(elapsed.count())/static_cast<double>(stop_ticks - start_ticks);
+      result.origin_ticks = stop_ticks;
+      result.origin       = std::chrono::duration_cast<duration>(stop_time.time_since_epoch());
+
+      return result;
+    }();
+
+    return calibration;
+  }
+
+  unsigned long long tsc_clock::_ticks() noexcept
+  {
+# if defined(_chz_impl_X86)
+    unsigned int processor;
+    return __rdtscp(&processor);
+# else
+    return 0;
+# endif
+  }
+
+  bool tsc_clock::_supported() noexcept
+  {
+# if defined(_chz_impl_X86) and defined(_MSC_VER)
+    int registers[4];
+    __cpuid(registers, static_cast<int>(0x80000000));
+    if (static_cast<unsigned>(registers[0]) < 0x80000007) return false;
+
+    __cpuid(registers, static_cast<int>(0x80000001));
+    const bool rdtscp = (registers[3] >> 27) & 1;
+
+    __cpuid(registers, static_cast<int>(0x80000007));
+    const bool invariant = (registers[3] >> 8) & 1;
+
+    return rdtscp and invariant;
+# elif defined(_chz_impl_X86)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx)) return false;
+    const bool rdtscp = (edx >> 27) & 1;
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+    const bool invariant = (edx >> 8) & 1;
+
+    return rdtscp and invariant;
+# else
+    return false;
+# endif
+  }
 //----------------------------------------------------------------------------------------------------------------------
   auto Stopwatch::split() noexcept -> _impl::_time<Unit::automatic, 0>
   {
@@ -641,13 +922,13 @@ namespace chz
 //----------------------------------------------------------------------------------------------------------------------
   Measure::Measure(const unsigned iterations_) noexcept :
     _iterations(iterations_),
-    _total_fmt((_iterations > 1) ? "total elapsed time: %ms [avg = %Dus]" : "total elapsed time: %ms")
+    _total_fmt((_iterations > 1) ? "total elapsed time: %ms [avg = %Dus]\n%S" : "total elapsed time: %ms")
   {}
 
   Measure::Measure(const unsigned iterations_, const char* const iteration_format_) noexcept :
     _iterations(iterations_),
     _split_fmt(iteration_format_ && *iteration_format_ ? iteration_format_ : nullptr),
-    _total_fmt((_iterations > 1) ? "total elapsed time: %ms [avg = %Dus]" : "total elapsed time: %ms")
+    _total_fmt((_iterations > 1) ? "total elapsed time: %ms [avg = %Dus]\n%S" : "total elapsed time: %ms")
   {}
 
   Measure::Measure(
@@ -667,6 +948,11 @@ namespace chz
     _total_fmt(total_format_ && *total_format_ ? total_format_ : nullptr)
   {}
 
+  Measure::Measure(const std::chrono::nanoseconds budget_, const char* const total_format_) noexcept :
+    _total_fmt(total_format_ && *total_format_ ? total_format_ : nullptr),
+    _budget(budget_)
+  {}
+
   void Measure::pause() noexcept
   {
     _stopwatch.pause();
@@ -682,9 +968,94 @@ namespace chz
     return _stopwatch.avoid();
   }
 
+  auto Measure::reject_outliers(const double mads_) noexcept -> Measure&
+  {
+    _outliers = mads_ > 0 ? mads_ : 0;
+    return *this;
+  }
+
+  auto Measure::statistics() const noexcept -> Statistics
+  {
+    Statistics statistics = {};
+
+    if (_budget.count())
+    {
+      statistics.calibrated = true;
+      statistics.samples    = _iterations;
+      statistics.mean       = _round/_iterations;
+      return statistics;
+    }
+
+    if _chz_impl_ABNORMAL(_recorded == 0)
+    {
+      return statistics;
+    }
+
+    std::vector<long long> samples(_recorded);
+    for (unsigned k = 0; k < _recorded; ++k)
+    {
+      samples[k] = static_cast<long long>(_samples[k].count());
+    }
+
+    std::vector<long long> deviations = samples;
+    const long long        median     = _impl::_median(deviations);
+
+    for (auto& deviation : deviations)
+    {
+      deviation = deviation > median ? deviation - median : median - deviation;
+    }
+
+    const long long mad = _impl::_median(deviations);
+
+    if (_outliers > 0 and mad > 0)
+    {
+      const double limit = _outliers*static_cast<double>(mad);
+
+      samples.erase(std::remove_if(samples.begin(), samples.end(), [&](const long long sample_){
+        return static_cast<double>(sample_ > median ? sample_ - median : median - sample_) > limit;
+      }), samples.end());
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    for (const auto sample : samples) sum += static_cast<double>(sample);
+    const double mean = sum/static_cast<double>(samples.size());
+
+    double squares = 0;
+    for (const auto sample : samples) squares += (static_cast<double>(sample) - mean)*(static_cast<double>(sample) - mean);
+    const double variance = samples.size() > 1 ? squares/static_cast<double>(samples.size() - 1) : 0;
+
+    deviations = samples;
+    const long long kept_median = _impl::_median(deviations);
+    for (auto& deviation : deviations)
+    {
+      deviation = deviation > kept_median ? deviation - kept_median : kept_median - deviation;
+    }
+
+    statistics.samples  = static_cast<unsigned>(samples.size());
+    statistics.rejected = _recorded - statistics.samples;
+    statistics.min      = std::chrono::nanoseconds{samples.front()};
+    statistics.max      = std::chrono::nanoseconds{samples.back()};
+    statistics.median   = std::chrono::nanoseconds{kept_median};
+    statistics.p90      = std::chrono::nanoseconds{_impl::_percentile(samples, 90)};
+    statistics.p99      = std::chrono::nanoseconds{_impl::_percentile(samples, 99)};
+    statistics.mean     = std::chrono::nanoseconds{static_cast<long long>(mean)};
+    statistics.stddev   = std::chrono::nanoseconds{static_cast<long long>(std::sqrt(variance))};
+    statistics.mad      = std::chrono::nanoseconds{_impl::_median(deviations)};
+
+    return statistics;
+  }
+
   auto Measure::begin() noexcept -> _iterator
   {
+    if (_budget.count())
+    {
+      _iterations = 1;
+    }
+
     _remaining = _iterations;
+    _recorded  = 0;
 
     _stopwatch.start();
     _stopwatch.reset();
@@ -704,19 +1075,52 @@ namespace chz
   
   bool Measure::good() noexcept
   {
-    const auto avoid = _stopwatch.avoid();
-
     if _chz_impl_EXPECTED(_remaining)
     {
       return true;
     }
 
+    const auto avoid    = _stopwatch.avoid();
     const auto duration = _stopwatch.total();
 
+    if (_budget.count())
+    {
+      _stopwatch.reset();
+
+      // rounds shorter than the budget only serve as warm-up, the next one is at most 10 times longer
+      if (duration.nanoseconds < _budget and _iterations < 1000000000)
+      {
+        const double ratio = duration.nanoseconds.count()
+          ? 1.4*static_cast<double>(_budget.count())/static_cast<double>(duration.nanoseconds.count()) : 10;
+        const double grown = static_cast<double>(_iterations)*std::min(std::max(ratio, 1.0), 10.0);
+
+        _iterations = std::max(_iterations + 1, static_cast<unsigned>(std::min(grown, 1e9)));
+        _remaining  = _iterations;
+
+        return true;
+      }
+
+      _round = duration.nanoseconds;
+    }
+
     if _chz_impl_EXPECTED(_total_fmt)
     {
+      std::string format = _total_fmt;
+
+      auto position = format.find("%S");
+      if (position != std::string::npos)
+      {
+        format.replace(position, 2, _impl::_statistics_as_string(statistics()));
+      }
+
+      position = format.find("%#");
+      if (position != std::string::npos)
+      {
+        format.replace(position, 2, std::to_string(_iterations));
+      }
+
       _chz_impl_DECLARE_LOCK(_impl::_out_mtx);
-      _io::out << _impl::_total_fmt(duration, _total_fmt, _iterations) << std::endl;
+      _io::out << _impl::_total_fmt(duration, std::move(format), _iterations) << std::endl;
     }
 
     return false;
@@ -724,9 +1128,26 @@ namespace chz
 
   void Measure::next() noexcept
   {
+    // calibrated rounds are timed as a whole, a split per iteration would dwarf short operations
+    if (_budget.count())
+    {
+      --_remaining;
+      return;
+    }
+
     const auto avoid = _stopwatch.avoid();
     const auto split = _stopwatch.split();
 
+    if _chz_impl_ABNORMAL(_samples == nullptr)
+    {
+      _samples.reset(new (std::nothrow) std::chrono::nanoseconds[_iterations]);
+    }
+
+    if _chz_impl_EXPECTED(_samples and _recorded < _iterations)
+    {
+      _samples[_recorded++] = split.nanoseconds;
+    }
+
     if (_split_fmt)
     {
       _chz_impl_DECLARE_LOCK(_impl::_out_mtx);
@@ -755,6 +1176,178 @@ namespace chz
   {
     return _measurement->avoid();
   }
+
+  template<typename T>
+  void Measure::Iteration::sink(const T& result_) const noexcept
+  {
+    do_not_optimize(result_);
+  }
+//----------------------------------------------------------------------------------------------------------------------
+  namespace _impl
+  {
+    struct _benchmark
+    {
+      const char* name;
+      void      (*body)(Measure&);
+    };
+
+    inline auto _benchmarks() noexcept -> std::vector<_benchmark>&
+    {
+      static std::vector<_benchmark> benchmarks;
+      return benchmarks;
+    }
+
+    struct _registrar final
+    {
+      _registrar(const char* const name_, void (*const body_)(Measure&)) noexcept
+      {
+        _benchmarks().push_back({name_, body_});
+      }
+    };
+
+    // value of '--option=value', nullptr if 'argument_' is another option
+    inline auto _option(const char* const argument_, const char* const option_) noexcept -> const char*
+    {
+      const size_t length = std::strlen(option_);
+
+      if (std::strncmp(argument_, option_, length) == 0 and argument_[length] == '=')
+      {
+        return argument_ + length + 1;
+      }
+
+      return nullptr;
+    }
+
+    inline auto _to_unsigned(const char* const text_) noexcept -> unsigned
+    {
+      return static_cast<unsigned>(std::strtoul(text_, nullptr, 10));
+    }
+
+    inline void _report(
+      const char* const format_, const char* const name_, const unsigned repetition_,
+      const Measure::Statistics& statistics_, const bool first_
+    ) noexcept
+    {
+      const long long fields[] = {
+        statistics_.mean.count(), statistics_.min.count(),    statistics_.median.count(), statistics_.p90.count(),
+        statistics_.p99.count(),  statistics_.max.count(),    statistics_.stddev.count(), statistics_.mad.count()
+      };
+      const char* const labels[] = {"mean", "min", "median", "p90", "p99", "max", "stddev", "mad"};
+      const size_t      n_known  = statistics_.calibrated ? 1 : sizeof(fields)/sizeof(*fields); // only the mean
+
+      if (std::strcmp(format_, "csv") == 0)
+      {
+        if (first_)
+        {
+          _io::out << "name,repetition,iterations";
+          for (const auto label : labels) _io::out << ',' << label << "_ns";
+          _io::out << '\n';
+        }
+
+        _io::out << name_ << ',' << repetition_ << ',' << statistics_.samples;
+        for (size_t k = 0; k < sizeof(fields)/sizeof(*fields); ++k)
+        {
+          _io::out << ',';
+          if (k < n_known) _io::out << fields[k]; // unknown fields are left empty
+        }
+        _io::out << '\n';
+      }
+      else if (std::strcmp(format_, "json") == 0)
+      {
+        _io::out << (first_ ? "{\"benchmarks\":[\n" : ",\n")
+          << "{\"name\":\"" << name_ << "\",\"repetition\":" << repetition_
+          << ",\"iterations\":" << statistics_.samples;
+        for (size_t k = 0; k < sizeof(fields)/sizeof(*fields); ++k)
+        {
+          _io::out << ",\"" << labels[k] << "_ns\":";
+          if (k < n_known) _io::out << fields[k];
+          else             _io::out << "null";
+        }
+        _io::out << '}';
+      }
+      else
+      {
+        _io::out << name_ << " #" << repetition_ << " (" << statistics_.samples << " iterations): "
+          << _statistics_as_string(statistics_) << '\n';
+      }
+    }
+  }
+
+# undef  CHZ_BENCHMARK
+# define CHZ_BENCHMARK(NAME)                                                                                 \
+    static void _chz_impl_benchmark_##NAME(chz::Measure& measure);                                          \
+    static const chz::_impl::_registrar _chz_impl_registrar_##NAME(#NAME, _chz_impl_benchmark_##NAME);      \
+    static void _chz_impl_benchmark_##NAME(chz::Measure& measure)
+
+# undef  CHZ_BENCHMARK_MAIN
+# define CHZ_BENCHMARK_MAIN()              \
+    int main(int argc, char* argv[])        \
+    {                                       \
+      return chz::run_benchmarks(argc, argv); \
+    }
+
+  int run_benchmarks(const int argc_, char* argv_[]) noexcept
+  {
+    const char* filter      = "";
+    const char* format      = "console";
+    unsigned    iterations  = 1000;
+    unsigned    budget      = 0; // milliseconds, calibrates the iteration count when set
+    unsigned    repetitions = 1;
+    unsigned    warmup      = 1;
+
+    for (int k = 1; k < argc_; ++k)
+    {
+      const char* value = nullptr;
+
+      if      ((value = _impl::_option(argv_[k], "--filter")))      filter      = value;
+      else if ((value = _impl::_option(argv_[k], "--format")))      format      = value;
+      else if ((value = _impl::_option(argv_[k], "--iterations")))  iterations  = _impl::_to_unsigned(value);
+      else if ((value = _impl::_option(argv_[k], "--budget")))      budget      = _impl::_to_unsigned(value);
+      else if ((value = _impl::_option(argv_[k], "--repetitions"))) repetitions = _impl::_to_unsigned(value);
+      else if ((value = _impl::_option(argv_[k], "--warmup")))      warmup      = _impl::_to_unsigned(value);
+      else
+      {
+        _io::out << "run_benchmarks: unknown argument \"" << argv_[k] << "\", expected"
+          " --filter=TEXT --iterations=N --budget=MS --repetitions=N --warmup=N --format=console|csv|json" << std::endl;
+        return 1;
+      }
+    }
+
+    if _chz_impl_ABNORMAL(iterations == 0)
+    {
+      iterations = 1;
+    }
+
+    bool first = true;
+
+    for (const auto& benchmark : _impl::_benchmarks())
+    {
+      if (std::strstr(benchmark.name, filter) == nullptr) continue;
+
+      for (unsigned k = 0; k < warmup; ++k)
+      {
+        Measure measure = budget ? Measure(std::chrono::milliseconds(budget), "") : Measure(iterations, "", "");
+        benchmark.body(measure);
+      }
+
+      for (unsigned repetition = 0; repetition < repetitions; ++repetition)
+      {
+        Measure measure = budget ? Measure(std::chrono::milliseconds(budget), "") : Measure(iterations, "", "");
+        benchmark.body(measure);
+
+        _impl::_report(format, benchmark.name, repetition, measure.statistics(), first);
+        first = false;
+      }
+    }
+
+    if (std::strcmp(format, "json") == 0)
+    {
+      _io::out << (first ? "{\"benchmarks\":[" : "\n") << "]}\n";
+    }
+
+    _io::out.flush();
+    return 0;
+  }
 }
 //----------------------------------------------------------------------------------------------------------------------
 # undef _chz_impl_PRAGMA
@@ -768,6 +1361,7 @@ namespace chz
 # undef _chz_impl_THREADLOCAL
 # undef _chz_impl_DECLARE_MUTEX
 # undef _chz_impl_DECLARE_LOCK
+# undef _chz_impl_X86
 //----------------------------------------------------------------------------------------------------------------------
 #else
 #error "chz: Support for ISO C++11 is required."
@@ -41,21 +41,41 @@ streams towards a common destination. See the included README.MD file for more i
 #ifndef _katagrafeas_hpp
 #define _katagrafeas_hpp
 //---necessary standard libraries---------------------------------------------------------------------------------------
-#include <ostream>   // for std::ostream
-#include <streambuf> // for std::streambuf
-#include <cstddef>   // for size_t
-#include <vector>    // for std::vector
-#include <memory>    // for std::unique_ptr
-#include <chrono>    // for std::chrono::system_clock::now, std::chrono::system_clock::to_time_t
-#include <iomanip>   // for std::put_time
-#include <ctime>     // for std::localtime, std::time_t
-#include <iostream>  // for std::clog, std::cerr
-#include <cstdio>    // for std::sprintf
+#include <ostream>     // for std::ostream
+#include <streambuf>   // for std::streambuf
+#include <cstddef>     // for size_t, std::ptrdiff_t
+#include <vector>      // for std::vector
+#include <memory>      // for std::unique_ptr
+#include <chrono>      // for std::chrono::system_clock::now, std::chrono::system_clock::to_time_t
+#include <ctime>       // for std::strftime, std::tm, std::time_t
+#include <string>      // for std::string
+#include <iostream>    // for std::clog, std::cerr
+#include <cstdio>      // for std::snprintf
+#include <cstring>     // for std::memchr, std::memcpy, std::memset, std::strchr, std::strlen, std::strstr
+#include <cstdint>     // for uintptr_t, std::intmax_t
+#include <cmath>       // for std::isfinite, std::fabs, std::signbit, std::fma
+#include <algorithm>   // for std::min, std::sort, std::remove_if, std::find
+#include <new>         // for std::nothrow
+#include <type_traits> // for std::decay, std::is_same, std::is_integral, std::integral_constant
+#include <atomic>      // for std::atomic
+#include <istream>     // for std::istream
+#include <initializer_list> // for std::initializer_list
 //---conditionally necessary standard libraries-------------------------------------------------------------------------
 #if defined(__STDCPP_THREADS__) and not defined(KTZ_NOT_THREADSAFE)
 # define _ktz_impl_THREADSAFE
-# include <atomic>   // for std::atomic
-# include <mutex>    // for std::mutex, std::lock_guard
+# include <mutex>     // for std::mutex, std::lock_guard, std::unique_lock
+# include <thread>    // for std::thread, std::this_thread::yield, std::this_thread::sleep_for
+# include <condition_variable> // for std::condition_variable
+#endif
+#if defined(__unix__) or defined(__APPLE__)
+# define _ktz_impl_POSIX
+# include <fcntl.h>    // for open, posix_fallocate, fallocate
+# include <sys/mman.h> // for mmap, munmap
+# include <unistd.h>   // for ftruncate, fsync, close, unlink, write
+# include <stdlib.h>   // for posix_memalign, free
+# include <csignal>    // for sigaction, raise
+# include <sys/uio.h>  // for writev, iovec
+# include <dirent.h>   // for opendir, readdir, closedir
 #endif
 //---Katagrafeas library------------------------------------------------------------------------------------------------
 namespace ktz
@@ -63,15 +83,193 @@ namespace ktz
   // ostream redirection aswell as prefixing and suffixing
   class Logger;
 
+  // destination of complete lines, usable in place of an ostream
+  class Sink;
+
+  // memory-mapped segment files
+  class MappedFile;
+
+  // files rotated by size or interval, maintained from a background thread
+  class RollingFile;
+
+  // file descriptor written in large blocks, bypassing iostreams
+  class RawFile;
+
+  // behavior of an async Logger whose queue is full
+  enum class Backpressure : unsigned char
+  {
+    block,            // wait for the background writer, nothing is lost
+    drop_newest,      // discard the line being logged
+    overwrite_oldest, // discard the oldest queued line
+    spill             // write the line to a fallback sink from the calling thread
+  };
+
 # define log_message(...)             // log a message
 # define indented_log(...)            // log a message using stack-based indentation
+# define trace_span(NAME)             // time the enclosing scope while tracing, NAME must be a string literal
 # define KTZ_WARNING(...)         // issue a warning
 # define KTZ_ERROR(message, code) // issue an error along with a code
+# define binary_log(...)              // record a message, formatted later by render_binary or dump_binary
+# define KTZ_LOG(LEVEL, ...)      // log a message at LEVEL (trace, debug, info, warning or error)
+
+  // execute the following at most 'RATE' times per second on average, in bursts of up to 'BURST'
+# define KTZ_RATE_LIMIT(RATE, BURST)
+
+  // execute the following once every 'N' times
+# define KTZ_SAMPLE(N)
+
+  // severity of a message, compare with KTZ_MIN_LEVEL (KTZ_LEVEL_TRACE ... KTZ_LEVEL_OFF) at compile time
+  enum class Level : unsigned char
+  {
+    trace,
+    debug,
+    info,
+    warning,
+    error,
+    off
+  };
+
+  inline // discard messages below 'level' at runtime
+  void set_level(Level level) noexcept;
+
+  inline // current runtime threshold
+  auto get_level() noexcept -> Level;
+
+  // static description of a logging call site, registered on its first execution
+  class Site;
+
+  inline // every call site executed so far
+  auto sites() noexcept -> std::vector<Site*>;
+
+  inline // force the sites of files whose path contains 'file' on or off, including those that first run later,
+  // return how many already registered sites matched
+  auto enable_sites(const char* file, bool enabled) noexcept -> size_t;
+
+  inline // write pending lines with async-signal-safe calls when a fatal signal arrives, then let it proceed
+  void flush_on_crash() noexcept;
+
+  inline // declare the calling thread before its first write to a linked ostream that may be restored concurrently
+  void register_thread() noexcept;
+
+  // encodings of structured log lines
+  enum class Encoding : unsigned char
+  {
+    json,  // {"level":"info","msg":"done","user":42}
+    logfmt // level=info msg=done user=42
+  };
+
+  inline // encoding used by log, JSON lines by default
+  void set_encoding(Encoding encoding) noexcept;
+
+  // log 'message' along with key, value pairs: log(Level::info, "done", "user", id, "latency_us", t)
+  template<typename... T>
+  void log(Level level, const char* message, const T&... fields) noexcept;
+
+  inline // render pending binary_log records as text
+  auto render_binary(std::ostream& text) noexcept -> size_t;
+
+  inline // write pending binary_log records for offline decoding
+  auto dump_binary(std::ostream& binary) noexcept -> size_t;
+
+  inline // render records written by dump_binary as text
+  auto decode_binary(std::istream& binary, std::ostream& text) noexcept -> size_t;
+
+  // periodically render or dump binary_log records from a background thread
+  class BinaryWriter;
+
+  inline // record the scopes of trace_span and indented_log, off by default
+  void set_tracing(bool enabled) noexcept;
+
+  inline // write recorded scopes as Chrome trace-event JSON (about://tracing, Perfetto), return how many
+  auto write_trace(std::ostream& json) noexcept -> size_t;
+
+# define KTZ_LEVEL_TRACE   0
+# define KTZ_LEVEL_DEBUG   1
+# define KTZ_LEVEL_INFO    2
+# define KTZ_LEVEL_WARNING 3
+# define KTZ_LEVEL_ERROR   4
+# define KTZ_LEVEL_OFF     5
+
+#if not defined(KTZ_MIN_LEVEL)
+# define KTZ_MIN_LEVEL KTZ_LEVEL_TRACE
+#endif
 
 #if defined(KTZ_MAX_LEN)
 # define _ktz_impl_MAX_LEN KTZ_MAX_LEN
 #else
 # define _ktz_impl_MAX_LEN 256
+#endif
+
+#if defined(KTZ_BUF_LEN)
+# define _ktz_impl_BUF_LEN KTZ_BUF_LEN
+#else
+# define _ktz_impl_BUF_LEN 512
+#endif
+
+#if defined(KTZ_PENDING_LINES)
+# define _ktz_impl_PENDING_LINES KTZ_PENDING_LINES
+#else
+# define _ktz_impl_PENDING_LINES 4
+#endif
+
+#if defined(KTZ_TIME_FORMATS)
+# define _ktz_impl_TIME_FORMATS KTZ_TIME_FORMATS
+#else
+# define _ktz_impl_TIME_FORMATS 4
+#endif
+
+#if defined(KTZ_BINARY_LEN)
+# define _ktz_impl_BINARY_LEN static_cast<size_t>(KTZ_BINARY_LEN)
+#else
+# define _ktz_impl_BINARY_LEN static_cast<size_t>(65536)
+#endif
+
+#if defined(KTZ_TRACE_LEN)
+# define _ktz_impl_TRACE_LEN static_cast<size_t>(KTZ_TRACE_LEN)
+#else
+# define _ktz_impl_TRACE_LEN static_cast<size_t>(16384)
+#endif
+
+#if defined(KTZ_MAX_ARGS)
+# define _ktz_impl_MAX_ARGS KTZ_MAX_ARGS
+#else
+# define _ktz_impl_MAX_ARGS 16
+#endif
+
+#if defined(KTZ_SEGMENT_LEN)
+# define _ktz_impl_SEGMENT_LEN KTZ_SEGMENT_LEN
+#else
+# define _ktz_impl_SEGMENT_LEN (64UL << 20)
+#endif
+
+#if defined(KTZ_WRITE_LEN)
+# define _ktz_impl_WRITE_LEN KTZ_WRITE_LEN
+#else
+# define _ktz_impl_WRITE_LEN 65536
+#endif
+
+#if defined(KTZ_BATCH_LEN)
+# define _ktz_impl_BATCH_LEN KTZ_BATCH_LEN
+#else
+# define _ktz_impl_BATCH_LEN 64
+#endif
+
+#if defined(KTZ_MAX_LOGGERS)
+# define _ktz_impl_MAX_LOGGERS KTZ_MAX_LOGGERS
+#else
+# define _ktz_impl_MAX_LOGGERS 16
+#endif
+
+#if defined(KTZ_STATS_SHARDS)
+# define _ktz_impl_STATS_SHARDS KTZ_STATS_SHARDS
+#else
+# define _ktz_impl_STATS_SHARDS 8
+#endif
+
+#if defined(KTZ_QUEUE_LEN)
+# define _ktz_impl_QUEUE_LEN KTZ_QUEUE_LEN
+#else
+# define _ktz_impl_QUEUE_LEN 1024
 #endif
 
   namespace _io
@@ -92,34 +290,320 @@ namespace ktz
   namespace _impl
   {
     class _interceptor;
+    class _async_writer;
+    struct _counters;
+
+    inline // wait for every Logger to write and flush its pending lines
+    void _flush_all() noexcept;
+
+    inline // write pending lines of every Logger using async-signal-safe calls only
+    void _salvage() noexcept;
+
+    // prefix/suffix format parsed once, rendered at most once per second per thread
+    class _time_format final
+    {
+    public:
+      inline _time_format(const char* format) noexcept;
+
+      inline // append up-to-date rendered text
+      void render(std::string& line) const noexcept;
+
+    private:
+      std::string _format; // strftime format, empty if the text is constant
+      std::string        _text; // constant text
+      unsigned long long _id;   // key of the thread-local rendering caches
+    };
   }
 // --Katagrafeas library: frontend struct and class definitions---------------------------------------------------------
+  class Site final
+  {
+  public:
+    const char* const file;
+    const unsigned    line;
+    const char* const format;
+    const Level       level;
+
+    constexpr // constant-initialized by the logging macros
+    Site(const char* file, unsigned line, const char* format, Level level) noexcept;
+
+    inline // function containing the site
+    auto function() const noexcept -> const char*;
+
+    inline // log regardless of the runtime level if 'enabled', never otherwise
+    void enable(bool enabled) noexcept;
+
+    inline // follow the runtime level again
+    void reset() noexcept;
+
+    inline // whether a message from this site would currently be logged
+    bool enabled() const noexcept;
+
+    inline // register on the first call, then decide from a single load of the state
+    bool admit(const char* function) noexcept;
+
+  private:
+    enum : unsigned char {_unregistered, _default, _forced_on, _forced_off};
+
+    const char*                _function = "";
+    std::atomic<unsigned char> _state    = {_unregistered};
+
+    inline bool _register(const char* function) noexcept;
+  };
+
+  class Sink
+  {
+  public:
+    struct Line
+    {
+      const char* data;
+      size_t      size;
+    };
+
+    virtual ~Sink() noexcept = default;
+
+    // write complete lines, or the beginning of one an ostream was flushed in, never from two threads at once
+    virtual void write(const char* data, size_t size) noexcept = 0;
+
+    // write several lines at once, such as a batch drained by an async Logger
+    virtual void write_lines(const Line* lines, size_t count) noexcept
+    {
+      for (size_t k = 0; k < count; ++k)
+      {
+        write(lines[k].data, lines[k].size);
+      }
+    }
+
+    // push written lines towards their final destination
+    virtual void flush() noexcept {}
+
+    // write lines, preceded by anything still buffered, using async-signal-safe calls only; the process is dying
+    virtual void salvage(const char*, size_t) noexcept {}
+  };
+
   class Logger final : public std::ostream
   {
   public:
     inline Logger(const std::ostream& ostream, const char* prefix = "", const char* suffix = "") noexcept;
 
+    inline // write to a sink instead of an ostream, the sink must outlive the Logger
+    Logger(Sink& sink, const char* prefix = "", const char* suffix = "") noexcept;
+
+    inline // write the same lines to every sink, each line is formatted once
+    Logger(std::initializer_list<Sink*> sinks, const char* prefix = "", const char* suffix = "") noexcept;
+
+    // identifies one link, restores it in constant time
+    struct Link
+    {
+      size_t             slot; // index in the routing table
+      unsigned long long id;   // identifier of the interceptor, tells a stale handle apart
+    };
+
     inline // redirect ostream (and backup its original buffer)
-    void link(std::ostream& ostream, const char* prefix = "", const char* suffix = "") noexcept;
+    auto link(std::ostream& ostream, const char* prefix = "", const char* suffix = "") noexcept -> Link;
+
+    inline // restore the ostream redirected by 'link', false if it was already restored
+    bool restore(Link link) noexcept;
 
-    inline // restore ostream's original buffer
+    inline // restore ostream's original buffer, undoing its latest link
     bool restore(std::ostream& ostream) noexcept;
 
     inline // restore all ostreams orginal buffer
     void restore_all() noexcept;
 
+    // lines that did not reach the sink because the async queue was full
+    struct Dropped
+    {
+      size_t lines;         // discarded or overwritten, lost
+      size_t bytes;
+      size_t spilled_lines; // written to the fallback sink instead
+      size_t spilled_bytes;
+    };
+
+    inline // write lines from a background thread, call before any output; 'fallback' must outlive the Logger
+    void async(unsigned capacity = _ktz_impl_QUEUE_LEN, Backpressure policy = Backpressure::block,
+      Sink* fallback = nullptr) noexcept;
+
+    inline // totals since async was called
+    auto dropped() const noexcept -> Dropped;
+
+    // cost of the Logger since its construction, summed over every thread
+    struct Stats
+    {
+      unsigned long long lines;       // lines handed to the sink
+      unsigned long long bytes;
+      unsigned long long flushes;     // flushes of the sink
+      unsigned long long nanoseconds; // spent inside overflow, xsputn and sync while measuring
+      size_t             queued;      // lines waiting in the async queue
+      unsigned long long latency[32]; // calls that took [2^k, 2^(k+1)) nanoseconds while measuring, the last is open
+    };
+
+    inline // time every call into the Logger's buffers, off by default
+    void measure(bool enabled) noexcept;
+
+    inline auto stats() const noexcept -> Stats;
+
     inline // restore all ostreams original buffer
     ~Logger() noexcept;
 
   private:
-    std::vector<std::unique_ptr<_impl::_interceptor>> _backups;
-    std::streambuf* const _buffer;                      // output buffer
-    std::ostream          _underlying_ostream{_buffer}; // underlying ostream linked to the output buffer
-    const char* const     _prefix;                      // prefix for new messages
-    const char* const     _suffix;                      // suffix for newlines
-    bool                  _prepend_flag = true;         // prepending flag
+    // restored interceptor, freed once no writer can still be inside it
+    struct _retiree
+    {
+      unsigned long long                   epoch;       // epoch in which it was restored
+      std::unique_ptr<_impl::_interceptor> interceptor;
+    };
+
+    std::unique_ptr<_impl::_interceptor>              _self;    // buffer of the Logger itself
+    std::vector<std::unique_ptr<_impl::_interceptor>> _links;   // routing table, indexed by Link::slot
+    std::vector<size_t>                               _free;    // empty slots of _links
+    std::vector<_retiree>                             _retired; // restored, awaiting reclamation
+    std::unique_ptr<_impl::_async_writer>             _async;
+    std::unique_ptr<_impl::_counters[]>               _counters; // _ktz_impl_STATS_SHARDS shards
+    std::atomic<bool>                                 _measuring = {false};
+    std::unique_ptr<Sink> _owned_sink;          // adapter owned when constructed from an ostream
+    Sink* const           _sink;                // output destination
+    _impl::_time_format   _prefix;              // prefix for new messages
+    _impl::_time_format   _suffix;              // suffix for newlines
+#if defined(_ktz_impl_THREADSAFE)
+    std::mutex            _mutex;               // serializes complete lines written to _sink
+    std::mutex            _links_mtx;           // serializes link and restore, never taken by writers
+#endif
     friend _impl::_interceptor;
+    friend void _impl::_flush_all() noexcept;
+    friend void _impl::_salvage() noexcept;
+
+    inline // wait until pending lines are written and flushed
+    void _flush_pending() noexcept;
+
+    inline // counters updated by the calling thread
+    auto _shard() noexcept -> _impl::_counters&;
+
+    inline // give the ostream of a slot its buffer back and retire the interceptor, _links_mtx held
+    void _unlink(size_t slot) noexcept;
+
+    inline // _unlink every slot, newest first, _links_mtx held
+    void _unlink_all() noexcept;
+
+    inline // free the retired interceptors no writer can reach anymore, _links_mtx held
+    void _reclaim() noexcept;
+  };
+
+# if defined(_ktz_impl_POSIX)
+  class MappedFile final : public Sink
+  {
+  public:
+    inline // append to memory-mapped files 'path'.0, 'path'.1, ... at most 'segment' bytes large, after existing ones,
+    // a line only spans two segments if it is larger than one
+    MappedFile(const char* path, size_t segment = _ktz_impl_SEGMENT_LEN) noexcept;
+
+    inline // unmap and trim the current segment to its written size
+    ~MappedFile() noexcept;
+
+    inline void write(const char* data, size_t size) noexcept override;
+
+    inline // only fills the current segment
+    void salvage(const char* data, size_t size) noexcept override;
+
+  private:
+    const std::string _path;
+    const size_t      _segment;
+    unsigned          _index;           // index of the current segment, after those of earlier runs
+    int               _fd    = -1;      // file descriptor of the current segment
+    char*             _map   = nullptr; // mapping of the current segment
+    size_t            _used  = 0;       // bytes written to the current segment
+
+    inline bool _open() noexcept;
+    inline void _close() noexcept;
+  };
+# endif
+# if defined(_ktz_impl_POSIX) and defined(_ktz_impl_THREADSAFE)
+  class RollingFile final : public Sink
+  {
+  public:
+    inline // append to 'path'.0, 'path'.1, ... after existing ones, rotating after 'size' bytes (0 for unbounded) or
+    // 'interval' seconds
+    RollingFile(const char* path, size_t size = _ktz_impl_SEGMENT_LEN, unsigned interval = 0, unsigned keep = 0) noexcept;
+
+    inline // write buffered lines, then sync and close every file
+    ~RollingFile() noexcept;
+
+    inline void write(const char* data, size_t size) noexcept override;
+
+    inline // a batch that overflows the buffer is written with a single writev
+    void write_lines(const Line* lines, size_t count) noexcept override;
+
+    inline void flush() noexcept override;
+
+    inline void salvage(const char* data, size_t size) noexcept override;
+
+  private:
+    using _clock = std::chrono::system_clock;
+
+    const std::string       _path;
+    const size_t            _size;
+    const _clock::duration  _interval;
+    const unsigned          _keep;              // number of files to retain, 0 to keep them all
+    int                     _fd       = -1;     // file being written to
+    unsigned                _index;             // index of the file being written to
+    size_t                  _written  = 0;      // bytes written to the current file
+    _clock::time_point      _deadline;          // time at which the current file rotates
+    std::unique_ptr<char[]> _buffer;            // lines not yet written to _fd
+    size_t                  _buffered = 0;
+    int                     _next     = -1;     // file preallocated by the background thread
+    std::vector<std::pair<int, unsigned>> _retired; // files to sync, close and apply retention to
+    bool                    _running  = true;
+    std::mutex              _mutex;             // only guards the handoff, never held during system calls
+    std::condition_variable _wakeup;
+    std::thread             _thread;
+
+    inline bool _due() const noexcept;
+    inline void _rotate() noexcept;
+    inline auto _prepare(unsigned index) noexcept -> int;
+
+    inline // sync and close a rotated file, then delete the files past the retention
+    void _retire(int fd, unsigned index) noexcept;
+
+    inline // delete the files past the retention when 'newest' is the last one
+    void _trim(unsigned newest) noexcept;
+
+    inline auto _name(unsigned index) const noexcept -> std::string;
+  };
+# endif
+# if defined(_ktz_impl_POSIX)
+  class RawFile final : public Sink
+  {
+  public:
+    inline // write to 'fd', closing it on destruction only if 'owned'
+    RawFile(int fd, bool owned = false) noexcept;
+
+    inline // create or truncate 'path' and write to it
+    RawFile(const char* path) noexcept;
+
+    inline // write the buffered lines, then close the file if owned
+    ~RawFile() noexcept;
+
+    inline void write(const char* data, size_t size) noexcept override;
+
+    inline void write_lines(const Line* lines, size_t count) noexcept override;
+
+    inline void flush() noexcept override;
+
+    inline void salvage(const char* data, size_t size) noexcept override;
+
+  private:
+    struct _free
+    {
+      void operator()(char* const buffer_) const noexcept { ::free(buffer_); }
+    };
+
+    const int                     _fd;
+    const bool                    _owned;
+    std::unique_ptr<char, _free>  _buffer;       // page aligned, _ktz_impl_WRITE_LEN bytes
+    size_t                        _buffered = 0;
+
+    static inline auto _allocate() noexcept -> char*;
   };
+# endif
 //---Katagrafeas library: backend forward declarations------------------------------------------------------------------
   namespace _impl
   {
@@ -160,193 +644,3946 @@ namespace ktz
 #   define _ktz_impl_THREADLOCAL         thread_local
 #   define _ktz_impl_ATOMIC(TYPE)        std::atomic<TYPE>
 #   define _ktz_impl_MAKE_MUTEX(...)     static std::mutex __VA_ARGS__
-#   define _ktz_impl_DECLARE_LOCK(MUTEX) std::lock_guard<decltype(MUTEX)> _lock{MUTEX}
+#   define _ktz_impl_MAKE_SHARED_MUTEX(NAME)                             \
+      inline auto NAME() noexcept -> std::mutex&                         \
+      {                                                                  \
+        static std::mutex mutex;                                         \
+        return mutex;                                                    \
+      }
+#   define _ktz_impl_DECLARE_LOCK(MUTEX) std::lock_guard<std::mutex> _lock{MUTEX}
 # else
 #   define _ktz_impl_THREADLOCAL
 #   define _ktz_impl_ATOMIC(TYPE)        TYPE
 #   define _ktz_impl_MAKE_MUTEX(...)
+#   define _ktz_impl_MAKE_SHARED_MUTEX(NAME)
 #   define _ktz_impl_DECLARE_LOCK(MUTEX)
 # endif
 
-    _ktz_impl_MAYBE_UNUSED static _ktz_impl_THREADLOCAL char _log_buf[_ktz_impl_MAX_LEN];
-    _ktz_impl_MAYBE_UNUSED static _ktz_impl_THREADLOCAL char _ilg_buf[_ktz_impl_MAX_LEN];
-    _ktz_impl_MAYBE_UNUSED static _ktz_impl_THREADLOCAL char _wrn_buf[_ktz_impl_MAX_LEN];
-    _ktz_impl_MAKE_MUTEX(_log_mtx, _ilg_mtx, _wrn_mtx);
+    _ktz_impl_MAKE_MUTEX(_log_mtx, _ilg_mtx, _wrn_mtx, _err_mtx);
 
-    class _interceptor final : public std::streambuf
+    // growable text buffer, only allocates past _ktz_impl_MAX_LEN characters
+    class _text final
     {
     public:
-      _interceptor(
-        Logger* const     stream_, std::ostream&     ostream_,
-        const char* const prefix_, const char* const suffix_
-      ) noexcept :
-        _ostream(&ostream_), _stream(stream_),
-        _prefix(prefix_),    _suffix(suffix_)
-      {}
-
-      _interceptor(
-        Logger* const     stream_,
-        const char* const prefix_, const char* const suffix_
-      ) noexcept :
-        _ostream(stream_), _stream(stream_),
-        _prefix(prefix_),  _suffix(suffix_)
-      {}
+      _text() noexcept = default;
+      _text(const _text&) = delete;
+      _text& operator=(const _text&) = delete;
 
-      ~_interceptor() noexcept
+      ~_text() noexcept
       {
-        _ostream->rdbuf(_buffer_backup);
+        if (_data != _local) delete[] _data;
       }
 
-      std::ostream* const    _ostream;
-    private:
-      std::streambuf* const _buffer_backup = _ostream->rdbuf();
-      Logger* const         _stream;
-      const char* const     _prefix;
-      const char* const     _suffix;
-
-      inline auto overflow(int_type character) -> int_type override;
-      inline auto sync() -> int override;
-    };
-
-    inline
-    auto _format_string(const char* const format_) -> decltype(std::put_time((const std::tm*)0, ""))
-    {
-      const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-      return std::put_time(std::localtime(&time), format_);
-    }
+      void append(const char* const data_, const size_t size_) noexcept
+      {
+        if (_reserve(size_)) _ktz_impl_LIKELY
+        {
+          std::memcpy(_data + _size, data_, size_);
+          _size += size_;
+        }
+      }
 
-    class _indented_log final
-    {
-    public:
-      _indented_log(const char* const text, const char* const caller = "") noexcept
+      void append(const size_t count_, const char character_) noexcept
       {
+        if (_reserve(count_)) _ktz_impl_LIKELY
         {
-          _ktz_impl_DECLARE_LOCK(_log_mtx);
-          _io::log << "log: " << caller << ": ";
+          std::memset(_data + _size, character_, count_);
+          _size += count_;
+        }
+      }
 
-          for (unsigned k = _indentation(); k--;)
-          {
-            _io::log << ' ';
-          }
+      void append(const char* const text_) noexcept
+      {
+        append(text_, std::strlen(text_));
+      }
 
-          _io::log << text << std::endl;
+      void push_back(const char character_) noexcept
+      {
+        if (_reserve(1)) _ktz_impl_LIKELY
+        {
+          _data[_size++] = character_;
         }
+      }
 
-        _indentation() += 2;
+      // writable room for 'extra' more characters past the end, nullptr if memory is exhausted
+      auto extend(const size_t extra_) noexcept -> char*
+      {
+        return _reserve(extra_) ? _data + _size : nullptr;
       }
 
-      ~_indented_log() noexcept
+      // keep 'count' characters written into the room given by extend
+      void commit(const size_t count_) noexcept
       {
-        _indentation() -= 2;
+        _size += count_;
       }
 
-    private:
-      auto _indentation() -> _ktz_impl_ATOMIC(unsigned)&
+      auto data() const noexcept -> const char*
       {
-        static _ktz_impl_ATOMIC(unsigned) indentation = {0};
-        return indentation;
+        return _data;
       }
-    };
 
-    constexpr void _log(...) noexcept {};
-  }
+      auto size() const noexcept -> size_t
+      {
+        return _size;
+      }
 
-# undef  log_message
-# define log_message(...)                         \
-    _impl::_log(([&](const char* const caller_){  \
-      using namespace ktz;                        \
-      std::sprintf(_impl::_log_buf, __VA_ARGS__); \
-      _ktz_impl_DECLARE_LOCK(_impl::_log_mtx);    \
-      _io::log << "log: " << caller_ << ": ";     \
-      _io::log << _impl::_log_buf << std::endl;   \
-    }(__func__), 0))
+      void clear() noexcept
+      {
+        _size = 0;
+      }
 
-# undef  indented_log
-# define indented_log(...)              _ktz_impl_ILOG_PRXY(__LINE__,    __VA_ARGS__)
-# define _ktz_impl_ILOG_PRXY(LINE, ...) _ktz_impl_ILOG_IMPL(LINE,        __VA_ARGS__)
-# define _ktz_impl_ILOG_IMPL(LINE, ...)           \
-    _impl::_indented_log _ilg_##LINE([&](){       \
-      using namespace ktz;                        \
-      std::sprintf(_impl::_ilg_buf, __VA_ARGS__); \
-      return _impl::_ilg_buf;                     \
-    }(), __func__)
+    private:
+      char*  _data     = _local;
+      size_t _size     = 0;
+      size_t _capacity = sizeof(_local);
+      char   _local[_ktz_impl_MAX_LEN];
 
-# undef  KTZ_WARNING
-# define KTZ_WARNING(...)                                                        \
-    [&](const char* const caller){                                               \
-      std::sprintf(_impl::_wrn_buf, __VA_ARGS__);                                \
-      _ktz_impl_DECLARE_LOCK(_impl::_wrn_mtx);                                   \
-      _io::wrn << "warning: " << caller << ": " << _impl::_wrn_buf << std::endl; \
-    }(__func__)
+      // make room for 'extra' more characters, false if memory is exhausted
+      bool _reserve(const size_t extra_) noexcept
+      {
+        if (_size + extra_ <= _capacity) _ktz_impl_LIKELY
+        {
+          return true;
+        }
 
-# undef  KTZ_ERROR
-# define KTZ_ERROR(return_value, ...)                                          \
-    return [&](const char* const caller){                                      \
-      std::sprintf(_impl::_err_buf, __VA_ARGS__);                              \
-      _ktz_impl_DECLARE_LOCK(_impl::_err_mtx);                                 \
-      _io::err << "error: " << caller << ": " << _impl::_err_buf << std::endl; \
-    }(__func__), return_value
-//----------------------------------------------------------------------------------------------------------------------
-  Logger::Logger(const std::ostream& ostream_, const char* const prefix_, const char* const suffix_) noexcept :
-    std::ostream(new _impl::_interceptor(this, prefix_, suffix_)),
-    _buffer(ostream_.rdbuf()), _prefix(prefix_), _suffix(suffix_)
-  {}
+        size_t capacity = 2 * _capacity;
+        while (capacity < _size + extra_) capacity *= 2;
 
-  Logger::~Logger() noexcept
-  {
-    restore_all();
-  }
+        const auto data = new (std::nothrow) char[capacity];
+        if (data == nullptr) _ktz_impl_UNLIKELY
+        {
+          return false;
+        }
 
-  void Logger::link(std::ostream& ostream_, const char* const prefix_, const char* const suffix_) noexcept
-  {
-    _backups.emplace_back(new _impl::_interceptor(this, ostream_, prefix_, suffix_));
-    ostream_.rdbuf(_backups.back().get()); // redirect towards the new interceptor
-  }
+        std::memcpy(data, _data, _size);
+        if (_data != _local) delete[] _data;
+
+        _data     = data;
+        _capacity = capacity;
+
+        return true;
+      }
+    };
+
+    // category of a formatted argument
+    enum class _kind : unsigned char
+    {
+      none,
+      integer,
+      floating,
+      string,
+      pointer
+    };
+
+    template<typename T, typename D = typename std::decay<T>::type>
+    constexpr auto _kind_of() noexcept -> _kind
+    {
+      return std::is_same<D, char*>::value or std::is_same<D, const char*>::value
+        or std::is_same<D, std::string>::value                                    ? _kind::string
+      : std::is_integral<D>::value or std::is_enum<D>::value                      ? _kind::integer
+      : std::is_floating_point<D>::value                                          ? _kind::floating
+      : std::is_pointer<D>::value or std::is_same<D, std::nullptr_t>::value       ? _kind::pointer
+      :                                                                             _kind::none;
+    }
+
+    // type-erased argument
+    struct _arg
+    {
+      _kind         kind;
+      bool          negative;
+      unsigned char size; // bytes of integers after promotion, 0 if unknown
+      union
+      {
+        unsigned long long integer;  // magnitude of integers
+        double             floating;
+        const void*        pointer;
+        struct
+        {
+          const char* data;
+          size_t      size;
+        } string;
+      };
+    };
+
+    template<typename T>
+    auto _make_arg(const T& value_, std::integral_constant<_kind, _kind::integer>) noexcept -> _arg
+    {
+      _arg arg;
+      arg.kind     = _kind::integer;
+      arg.size     = sizeof(T) < sizeof(int) ? sizeof(int) : sizeof(T);
+      arg.negative = static_cast<long long>(value_) < 0 and std::is_signed<T>::value;
+      arg.integer  = arg.negative
+        ? 0ULL - static_cast<unsigned long long>(static_cast<long long>(value_))
+        : static_cast<unsigned long long>(value_);
+      return arg;
+    }
+
+    template<typename T>
+    auto _make_arg(const T& value_, std::integral_constant<_kind, _kind::floating>) noexcept -> _arg
+    {
+      _arg arg;
+      arg.kind     = _kind::floating;
+      arg.negative = std::signbit(value_);
+      arg.floating = static_cast<double>(value_);
+      return arg;
+    }
+
+    inline
+    auto _make_arg(const char* const value_, std::integral_constant<_kind, _kind::string>) noexcept -> _arg
+    {
+      _arg arg;
+      arg.kind        = _kind::string;
+      arg.negative    = false;
+      arg.string.data = value_ ? value_ : "(null)";
+      arg.string.size = std::strlen(arg.string.data);
+      return arg;
+    }
+
+    inline
+    auto _make_arg(const std::string& value_, std::integral_constant<_kind, _kind::string>) noexcept -> _arg
+    {
+      _arg arg;
+      arg.kind        = _kind::string;
+      arg.negative    = false;
+      arg.string.data = value_.data();
+      arg.string.size = value_.size();
+      return arg;
+    }
+
+    template<typename T>
+    auto _make_arg(const T& value_, std::integral_constant<_kind, _kind::pointer>) noexcept -> _arg
+    {
+      _arg arg;
+      arg.kind     = _kind::pointer;
+      arg.negative = false;
+      arg.pointer  = value_;
+      return arg;
+    }
+
+    template<typename T>
+    auto _make_arg(const T& value_) noexcept -> _arg
+    {
+      return _make_arg(value_, std::integral_constant<_kind, _kind_of<T>()>());
+    }
+
+    // compile-time format checking
+    template<typename... T>
+    struct _types {};
+
+    template<typename... T>
+    auto _types_of(const T&...) noexcept -> _types<T...>; // only used in unevaluated contexts
+
+    constexpr
+    bool _is_modifier(const char character_) noexcept
+    {
+      return character_ == '-' or character_ == '+' or character_ == ' ' or character_ == '#'
+          or (character_ >= '0' and character_ <= '9') or character_ == '.'
+          or character_ == 'h' or character_ == 'l' or character_ == 'L'
+          or character_ == 'z' or character_ == 'j' or character_ == 't';
+    }
+
+    constexpr // pointer to the conversion character of the specification starting at 'format'
+    auto _conversion(const char* const format_) noexcept -> const char*
+    {
+      return _is_modifier(*format_) ? _conversion(format_ + 1) : format_;
+    }
+
+    constexpr // conversion character of the nth specification, '\0' if there is none
+    char _nth_conversion(const char* const format_, const unsigned n_) noexcept
+    {
+      return *format_ == '\0'                   ? '\0'
+      : *format_ != '%'                         ? _nth_conversion(format_ + 1, n_)
+      : format_[1] == '%'                       ? _nth_conversion(format_ + 2, n_)
+      : n_ == 0                                 ? *_conversion(format_ + 1)
+      : *_conversion(format_ + 1) == '\0'       ? '\0'
+      :                                           _nth_conversion(_conversion(format_ + 1) + 1, n_ - 1);
+    }
+
+    constexpr
+    bool _accepts(const char conversion_, const _kind kind_) noexcept
+    {
+      return kind_ == _kind::integer  ? conversion_ == 'd' or conversion_ == 'i' or conversion_ == 'u'
+                                     or conversion_ == 'x' or conversion_ == 'X' or conversion_ == 'o'
+                                     or conversion_ == 'c'
+      :      kind_ == _kind::floating ? conversion_ == 'f' or conversion_ == 'F' or conversion_ == 'e'
+                                     or conversion_ == 'E' or conversion_ == 'g' or conversion_ == 'G'
+                                     or conversion_ == 'a' or conversion_ == 'A'
+      :      kind_ == _kind::string   ? conversion_ == 's' or conversion_ == 'p'
+      :      kind_ == _kind::pointer  ? conversion_ == 'p'
+      :                                 false;
+    }
+
+    constexpr
+    bool _count_matches(const char* const format_, const unsigned n_, _types<>) noexcept
+    {
+      return _nth_conversion(format_, n_) == '\0';
+    }
+
+    template<typename T, typename... Ts>
+    constexpr
+    bool _count_matches(const char* const format_, const unsigned n_, _types<T, Ts...>) noexcept
+    {
+      return _nth_conversion(format_, n_) != '\0' and _count_matches(format_, n_ + 1, _types<Ts...>());
+    }
+
+    constexpr
+    bool _kinds_match(const char* const, const unsigned, _types<>) noexcept
+    {
+      return true;
+    }
+
+    template<typename T, typename... Ts>
+    constexpr
+    bool _kinds_match(const char* const format_, const unsigned n_, _types<T, Ts...>) noexcept
+    {
+      return _accepts(_nth_conversion(format_, n_), _kind_of<T>())
+        and _kinds_match(format_, n_ + 1, _types<Ts...>());
+    }
+
+    template<typename F, typename... T> // F is the type of the format itself
+    constexpr
+    bool _count_matches(const char* const format_, _types<F, T...>) noexcept
+    {
+      return _count_matches(format_, 0, _types<T...>());
+    }
+
+    template<typename F, typename... T> // F is the type of the format itself
+    constexpr
+    bool _kinds_match(const char* const format_, _types<F, T...>) noexcept
+    {
+      return _kinds_match(format_, 0, _types<T...>());
+    }
+
+#   define _ktz_impl_FORMAT_OF(FORMAT, ...) FORMAT
+#   define _ktz_impl_CHECK_FORMAT(NAME, ...)                                             \
+      static_assert(ktz::_impl::_count_matches(_ktz_impl_FORMAT_OF(__VA_ARGS__, ~),       \
+        decltype(ktz::_impl::_types_of(__VA_ARGS__))()),                                  \
+        NAME ": the number of arguments does not match the format.");                     \
+      static_assert(ktz::_impl::_kinds_match(_ktz_impl_FORMAT_OF(__VA_ARGS__, ~),         \
+        decltype(ktz::_impl::_types_of(__VA_ARGS__))()),                                  \
+        NAME ": an argument type does not match its conversion specifier.")
+
+    // parsed conversion specification
+    struct _spec
+    {
+      bool     left       = false;
+      bool     plus       = false;
+      bool     space      = false;
+      bool     alternate  = false;
+      bool     zero       = false;
+      unsigned width      = 0;
+      int      precision  = -1;
+      unsigned length     = 0; // bytes of the length modifier, 0 if there is none
+      char     conversion = '\0';
+    };
+
+    inline
+    auto _parse_spec(const char* format_, _spec& spec_) noexcept -> const char*
+    {
+      for (;; ++format_)
+      {
+        switch (*format_)
+        {
+          case '-': spec_.left      = true; continue;
+          case '+': spec_.plus      = true; continue;
+          case ' ': spec_.space     = true; continue;
+          case '#': spec_.alternate = true; continue;
+          case '0': spec_.zero      = true; continue;
+          default: break;
+        }
+        break;
+      }
+
+      while (*format_ >= '0' and *format_ <= '9')
+      {
+        spec_.width = 10*spec_.width + static_cast<unsigned>(*format_++ - '0');
+      }
+
+      if (*format_ == '.')
+      {
+        spec_.precision = 0;
+        while (*++format_ >= '0' and *format_ <= '9')
+        {
+          spec_.precision = 10*spec_.precision + (*format_ - '0');
+        }
+      }
+
+      switch (*format_)
+      {
+        case 'h': spec_.length = format_[1] == 'h' ? sizeof(char) : sizeof(short);    break;
+        case 'l': spec_.length = format_[1] == 'l' ? sizeof(long long) : sizeof(long); break;
+        case 'z': spec_.length = sizeof(size_t);                                       break;
+        case 'j': spec_.length = sizeof(std::intmax_t);                                break;
+        case 't': spec_.length = sizeof(std::ptrdiff_t);                               break;
+        default:                                                                       break;
+      }
+
+      while (*format_ and _is_modifier(*format_)) ++format_;
+
+      spec_.conversion = *format_;
+
+      return *format_ ? format_ + 1 : format_;
+    }
+
+    // write 'digits' with sign/base prefix, precision zeros and width padding
+    inline
+    void _pad(
+      _text& out_, const _spec& spec_, const char* const prefix_, const size_t prefix_size_,
+      const char* const digits_, const size_t n_digits_, size_t n_zeros_) noexcept
+    {
+      size_t total = prefix_size_ + n_zeros_ + n_digits_;
+      size_t n_spaces = 0;
+
+      if (spec_.width > total)
+      {
+        if (spec_.zero and not spec_.left and spec_.precision < 0 and spec_.conversion != 's'
+          and spec_.conversion != 'c')
+        {
+          n_zeros_ += spec_.width - total;
+        }
+        else
+        {
+          n_spaces = spec_.width - total;
+        }
+      }
+
+      if (not spec_.left) out_.append(n_spaces, ' ');
+      out_.append(prefix_, prefix_size_);
+      out_.append(n_zeros_, '0');
+      out_.append(digits_, n_digits_);
+      if (spec_.left) out_.append(n_spaces, ' ');
+    }
+
+    // write digits of 'value' in 'base' ending at 'end', return start
+    inline
+    auto _digits(unsigned long long value_, const unsigned base_, const bool upper_, char* end_) noexcept -> char*
+    {
+      static constexpr char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+      if (base_ == 10) _ktz_impl_LIKELY
+      {
+        while (value_ >= 100)
+        {
+          const auto pair = static_cast<size_t>(value_ % 100) * 2;
+          value_ /= 100;
+          *--end_ = pairs[pair + 1];
+          *--end_ = pairs[pair];
+        }
+
+        if (value_ >= 10)
+        {
+          const auto pair = static_cast<size_t>(value_) * 2;
+          *--end_ = pairs[pair + 1];
+          *--end_ = pairs[pair];
+        }
+        else
+        {
+          *--end_ = static_cast<char>('0' + value_);
+        }
+
+        return end_;
+      }
+
+      const char* const symbols = upper_ ? "0123456789ABCDEF" : "0123456789abcdef";
+
+      do
+      {
+        *--end_ = symbols[value_ % base_];
+        value_ /= base_;
+      } while (value_);
+
+      return end_;
+    }
+
+    inline
+    void _format_integer(_text& out_, const _spec& spec_, const _arg& arg_) noexcept
+    {
+      char buffer[32];
+      char* const end = buffer + sizeof(buffer);
+
+      // two's complement bits, truncated like printf to the length modifier or else to the promoted argument
+      const unsigned size = spec_.length ? spec_.length : arg_.size ? arg_.size : sizeof(unsigned long long);
+      const auto     mask = size < sizeof(unsigned long long) ? (1ULL << 8*size) - 1 : ~0ULL;
+      const auto     bits = (arg_.negative ? 0ULL - arg_.integer : arg_.integer) & mask;
+
+      if (spec_.conversion == 'c')
+      {
+        const char character = static_cast<char>(bits);
+        _pad(out_, spec_, "", 0, &character, 1, 0);
+        return;
+      }
+
+      unsigned    base   = 10;
+      const char* prefix = "";
+      auto        value  = bits;
+      bool        upper  = false;
+
+      switch (spec_.conversion)
+      {
+        case 'x': base = 16; prefix = spec_.alternate and value ? "0x" : ""; break;
+        case 'X': base = 16; prefix = spec_.alternate and value ? "0X" : ""; upper = true; break;
+        case 'o': base = 8;  break;
+        case 'u': break;
+        default:
+        {
+          const bool negative = (bits >> (8*size - 1)) & 1;
+          value  = negative ? (0ULL - bits) & mask : bits;
+          prefix = negative ? "-" : spec_.plus ? "+" : spec_.space ? " " : "";
+          break;
+        }
+      }
+
+      char* start = end;
+      if (value != 0 or spec_.precision != 0)
+      {
+        start = _digits(value, base, upper, end);
+      }
+
+      const auto n_digits = static_cast<size_t>(end - start);
+      const auto n_zeros  = spec_.precision > 0 and static_cast<size_t>(spec_.precision) > n_digits
+        ? static_cast<size_t>(spec_.precision) - n_digits : 0;
+
+      // the alternate octal form only guarantees a leading zero, it never adds a second one
+      if (base == 8 and spec_.alternate and n_zeros == 0 and (n_digits == 0 or *start != '0'))
+      {
+        prefix = "0";
+      }
+
+      _pad(out_, spec_, prefix, std::strlen(prefix), start, n_digits, n_zeros);
+    }
+
+    inline
+    void _format_floating(_text& out_, const _spec& spec_, const _arg& arg_) noexcept
+    {
+      const double value     = arg_.floating;
+      const int    precision = spec_.precision < 0 ? 6 : spec_.precision;
+
+      // fixed notation fast path, exact integer part and at most 9 decimals
+      if ((spec_.conversion == 'f' or spec_.conversion == 'F') and precision <= 9
+        and std::isfinite(value) and std::fabs(value) < 9007199254740992.0) _ktz_impl_LIKELY
+      {
+        static constexpr unsigned long long powers[] = {
+          1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+        };
+
+        const double magnitude = std::fabs(value);
+        const auto   scale     = powers[precision];
+        auto         integral  = static_cast<unsigned long long>(magnitude);
+        const double scaled    = (magnitude - static_cast<double>(integral))*static_cast<double>(scale);
+        auto         fraction  = static_cast<unsigned long long>(scaled);
+        const double remainder = scaled - static_cast<double>(fraction);
+
+        // 'scaled' is rounded: on an apparent tie its exact error decides, a true tie rounds to even
+        const bool   tie   = remainder == 0.5;
+        const double error = tie
+          ? std::fma(magnitude - static_cast<double>(integral), static_cast<double>(scale), -scaled) : 0.0;
+        const bool   odd   = ((precision > 0 ? fraction : integral) & 1) != 0;
+
+        if (remainder > 0.5 or (tie and (error > 0.0 or (error == 0.0 and odd))))
+        {
+          if (++fraction == scale)
+          {
+            fraction = 0;
+            ++integral;
+          }
+        }
+
+        char buffer[40];
+        char* const end = buffer + sizeof(buffer);
+        char* start = end;
+
+        if (precision > 0)
+        {
+          start = _digits(fraction, 10, false, end);
+          while (end - start < precision) *--start = '0';
+          *--start = '.';
+        }
+        else if (spec_.alternate)
+        {
+          *--start = '.';
+        }
+
+        start = _digits(integral, 10, false, start);
+
+        const char* const prefix = arg_.negative ? "-" : spec_.plus ? "+" : spec_.space ? " " : "";
+        _spec spec = spec_;
+        spec.precision = -1;
+        _pad(out_, spec, prefix, std::strlen(prefix), start, static_cast<size_t>(end - start), 0);
+        return;
+      }
+
+      // other notations are delegated to the C library with a rebuilt specification
+      char specification[16] = {'%'};
+      size_t k = 1;
+      if (spec_.left)      specification[k++] = '-';
+      if (spec_.plus)      specification[k++] = '+';
+      if (spec_.space)     specification[k++] = ' ';
+      if (spec_.alternate) specification[k++] = '#';
+      if (spec_.zero)      specification[k++] = '0';
+      specification[k++] = '*';
+      if (spec_.precision >= 0)
+      {
+        specification[k++] = '.';
+        specification[k++] = '*';
+      }
+      specification[k++] = spec_.conversion;
+
+      // measured first, then printed straight into the text, so no length is ever truncated
+      const auto print = [&](char* const buffer_, const size_t size_) noexcept -> int
+      {
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wformat-nonliteral"
+        return spec_.precision >= 0
+          ? std::snprintf(buffer_, size_, specification, static_cast<int>(spec_.width), precision, value)
+          : std::snprintf(buffer_, size_, specification, static_cast<int>(spec_.width), value);
+#   pragma GCC diagnostic pop
+      };
+
+      const int size = print(nullptr, 0);
+      if (size <= 0) _ktz_impl_UNLIKELY
+      {
+        return;
+      }
+
+      if (const auto buffer = out_.extend(static_cast<size_t>(size) + 1)) _ktz_impl_LIKELY
+      {
+        print(buffer, static_cast<size_t>(size) + 1);
+        out_.commit(static_cast<size_t>(size));
+      }
+    }
+
+    inline
+    void _format_arg(_text& out_, const _spec& spec_, const _arg& arg_) noexcept
+    {
+      switch (arg_.kind)
+      {
+        case _kind::integer:
+          _format_integer(out_, spec_, arg_);
+          break;
+
+        case _kind::floating:
+          _format_floating(out_, spec_, arg_);
+          break;
+
+        case _kind::string:
+          if (spec_.conversion == 's')
+          {
+            const auto size = spec_.precision >= 0 and static_cast<size_t>(spec_.precision) < arg_.string.size
+              ? static_cast<size_t>(spec_.precision) : arg_.string.size;
+            _pad(out_, spec_, "", 0, arg_.string.data, size, 0);
+            break;
+          }
+          _format_arg(out_, spec_, _make_arg(static_cast<const void*>(arg_.string.data)));
+          break;
+
+        case _kind::pointer:
+        {
+          char buffer[32];
+          char* const end   = buffer + sizeof(buffer);
+          char* const start = _digits(reinterpret_cast<uintptr_t>(arg_.pointer), 16, false, end);
+          _pad(out_, spec_, "0x", 2, start, static_cast<size_t>(end - start), 0);
+          break;
+        }
+
+        case _kind::none: _ktz_impl_UNLIKELY
+        default:
+          break;
+      }
+    }
+
+    inline // format 'args' according to a printf-style 'format'
+    void _vformat(_text& out_, const char* format_, const _arg* const args_, const size_t n_args_) noexcept
+    {
+      size_t next = 0;
+
+      while (*format_)
+      {
+        const char* const percent = std::strchr(format_, '%');
+
+        if (percent == nullptr)
+        {
+          out_.append(format_);
+          return;
+        }
+
+        out_.append(format_, static_cast<size_t>(percent - format_));
+        format_ = percent + 1;
+
+        if (*format_ == '%')
+        {
+          out_.push_back('%');
+          ++format_;
+          continue;
+        }
+
+        _spec spec;
+        format_ = _parse_spec(format_, spec);
+
+        if (spec.conversion == '\0') _ktz_impl_UNLIKELY
+        {
+          return;
+        }
+
+        if (next < n_args_) _ktz_impl_LIKELY
+        {
+          _format_arg(out_, spec, args_[next++]);
+        }
+      }
+    }
+
+    template<typename... T>
+    void _format(_text& out_, const char* const format_, const T&... args_) noexcept
+    {
+      const _arg args[] = {_make_arg(args_)..., _arg()};
+      _vformat(out_, format_, args, sizeof...(T));
+    }
+
+    inline // non-zero identifier, unique for the lifetime of the process
+    auto _unique_id() noexcept -> unsigned long long
+    {
+      static _ktz_impl_ATOMIC(unsigned long long) id = {0};
+      return ++id;
+    }
+
+    inline // nanoseconds of the steady clock
+    auto _steady_ns() noexcept -> unsigned long long
+    {
+      return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // statistics of a Logger updated by a subset of the threads, kept on its own cache lines
+    struct _counters
+    {
+      char                            _padding[64];
+      std::atomic<unsigned long long> lines       = {0};
+      std::atomic<unsigned long long> bytes       = {0};
+      std::atomic<unsigned long long> flushes     = {0};
+      std::atomic<unsigned long long> nanoseconds = {0};
+      std::atomic<unsigned long long> latency[32];
+
+      _counters() noexcept
+      {
+        for (auto& bucket : latency) bucket.store(0, std::memory_order_relaxed);
+      }
+
+      void measured(const unsigned long long begin_) noexcept
+      {
+        const unsigned long long elapsed = _steady_ns() - begin_;
+
+        unsigned bucket = 0;
+        while (bucket < 31 and (elapsed >> (bucket + 1))) ++bucket;
+
+        nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        latency[bucket].fetch_add(1, std::memory_order_relaxed);
+      }
+    };
+
+    _ktz_impl_MAKE_SHARED_MUTEX(_epochs_mtx)
+
+    // quiescent-state based reclamation: an object retired in an epoch is freed once every thread has announced a
+    // later epoch, readers only ever store to their own record
+    class _epoch final
+    {
+      struct _owner;
+    public:
+      // the calling thread may hold references to interceptors, it announces the current epoch once it leaves the
+      // outermost section: a buffer may write into another linked stream from within its own xsputn or sync
+      class section final
+      {
+      public:
+        section() noexcept :
+          _thread(_local())
+        {
+          ++_thread.depth;
+        }
+
+        ~section() noexcept
+        {
+          if (--_thread.depth == 0) _ktz_impl_LIKELY
+          {
+            _quiescent(*_thread.record);
+          }
+        }
+
+      private:
+        _owner& _thread;
+      };
+
+      static // register the calling thread outside of any section, it holds no reference yet
+      void enter() noexcept
+      {
+        _owner& thread = _local();
+
+        if (thread.depth == 0)
+        {
+          _quiescent(*thread.record);
+        }
+      }
+
+      static // close the current epoch, objects unreachable from now on were retired in it
+      auto retire() noexcept -> unsigned long long
+      {
+        return _global().fetch_add(1, std::memory_order_acq_rel);
+      }
+
+      static // objects retired in an earlier epoch are unreachable to every thread
+      auto oldest() noexcept -> unsigned long long
+      {
+        unsigned long long oldest = _global().load(std::memory_order_acquire);
+
+        _ktz_impl_DECLARE_LOCK(_epochs_mtx());
+        for (const auto& record : _records())
+        {
+          if (not record->orphan.load(std::memory_order_acquire))
+          {
+            oldest = std::min(oldest, record->seen.load(std::memory_order_acquire));
+          }
+        }
+
+        return oldest;
+      }
+
+    private:
+      struct _record
+      {
+        std::atomic<unsigned long long> seen   = {0};     // latest epoch announced by the owning thread
+        std::atomic<bool>               orphan = {false}; // owning thread has exited
+      };
+
+      struct _owner
+      {
+        _record* const record = _acquire();
+        unsigned       depth  = 0; // sections the thread is in
+        ~_owner() noexcept { record->orphan.store(true, std::memory_order_release); }
+      };
+
+      static // the calling thread holds no reference to a retired object
+      void _quiescent(_record& record_) noexcept
+      {
+        const unsigned long long now = _global().load(std::memory_order_acquire);
+
+        if (record_.seen.load(std::memory_order_relaxed) != now) _ktz_impl_UNLIKELY
+        {
+          record_.seen.store(now, std::memory_order_release);
+        }
+      }
+
+      static
+      auto _global() noexcept -> std::atomic<unsigned long long>&
+      {
+        static std::atomic<unsigned long long> epoch = {1};
+        return epoch;
+      }
+
+      // every record ever used, guarded by _epochs_mtx(), never destroyed: Loggers with static storage duration
+      // are constructed before it and may still be written to or destroyed after it would be
+      static
+      auto _records() noexcept -> std::vector<std::unique_ptr<_record>>&
+      {
+        static std::vector<std::unique_ptr<_record>>& all = *new std::vector<std::unique_ptr<_record>>;
+        return all;
+      }
+
+      static
+      auto _local() noexcept -> _owner&
+      {
+        static _ktz_impl_THREADLOCAL _owner owner;
+        return owner;
+      }
+
+      static
+      auto _acquire() noexcept -> _record*
+      {
+        _ktz_impl_DECLARE_LOCK(_epochs_mtx());
+
+        _record* record = nullptr;
+
+        // reuse the record of an exited thread
+        for (auto& orphan : _records())
+        {
+          if (orphan->orphan.load(std::memory_order_relaxed))
+          {
+            record = orphan.get();
+            break;
+          }
+        }
+
+        if (record == nullptr)
+        {
+          _records().emplace_back(new _record);
+          record = _records().back().get();
+        }
+
+        // the thread may already hold a pointer loaded before it got here: nothing is reclaimed until it announces
+        record->seen.store(0, std::memory_order_release);
+        record->orphan.store(false, std::memory_order_release);
+
+        return record;
+      }
+    };
+
+# if defined(_ktz_impl_THREADSAFE)
+    // bounded lock-free multi-producer queue of lines drained by a single background thread
+    class _async_writer final
+    {
+    public:
+      std::atomic<size_t>             dropped_lines = {0}; // lines the backpressure policy discarded
+      std::atomic<size_t>             dropped_bytes = {0};
+      std::atomic<size_t>             spilled_lines = {0}; // lines written to _fallback instead of _sink
+      std::atomic<size_t>             spilled_bytes = {0};
+      std::atomic<unsigned long long> flushes       = {0}; // flushes of _sink by the writer thread
+      std::atomic<unsigned long long> written_lines = {0}; // lines written to _sink by the writer thread
+      std::atomic<unsigned long long> written_bytes = {0};
+
+      _async_writer(Sink* const sink_, unsigned capacity_, const Backpressure policy_, Sink* const fallback_) noexcept :
+        _capacity(_round_up(capacity_)),
+        _slots(new _slot[_capacity]),
+        _sink(sink_),
+        _policy(policy_),
+        _fallback(fallback_),
+        _staging(policy_ == Backpressure::overwrite_oldest ? new char[_ktz_impl_BATCH_LEN*_ktz_impl_MAX_LEN] : nullptr)
+      {
+        for (size_t k = 0; k < _capacity; ++k)
+        {
+          _slots[k].sequence.store(k, std::memory_order_relaxed);
+        }
+
+        _thread = std::thread(&_async_writer::_run, this);
+      }
+
+      ~_async_writer() noexcept
+      {
+        _running.store(false, std::memory_order_release);
+        _thread.join();
+      }
+
+      // wait until every line pushed so far was written and flushed
+      void wait() noexcept
+      {
+        if (std::this_thread::get_id() == _thread.get_id()) return;
+
+        const size_t target = _enqueue.load(std::memory_order_acquire);
+
+        while (_flushed.load(std::memory_order_acquire) < target)
+        {
+          std::this_thread::yield();
+        }
+
+        if (_fallback)
+        {
+          std::lock_guard<std::mutex> lock(_spill_mtx);
+          _fallback->flush();
+        }
+      }
+
+      // hand queued lines to Sink::salvage, claimed slots stop the writer thread if it is still running
+      void salvage() noexcept
+      {
+        for (size_t position = _dequeue.load(std::memory_order_acquire);; ++position)
+        {
+          _slot& slot     = _slots[position & (_capacity - 1)];
+          size_t sequence = position + 1;
+
+          if (not slot.sequence.compare_exchange_strong(sequence, 0, std::memory_order_acquire)) break;
+
+          _sink->salvage(slot.heap ? slot.heap : slot.text, slot.size);
+        }
+
+        if (_fallback)
+        {
+          _fallback->salvage(nullptr, 0);
+        }
+      }
+
+      // lines pushed but not written yet, overwritten lines are skipped by _dequeue only once the writer
+      // reaches them, but never more than a full queue of them still holds a line
+      auto queued() const noexcept -> size_t
+      {
+        const size_t dequeue = _dequeue.load(std::memory_order_acquire);
+        const size_t enqueue = _enqueue.load(std::memory_order_acquire);
+        return enqueue > dequeue ? std::min(enqueue - dequeue, _capacity) : 0;
+      }
+
+      void push(const char* const data_, const size_t size_) noexcept
+      {
+        size_t position = _enqueue.load(std::memory_order_relaxed);
+        _slot* slot;
+
+        while (true)
+        {
+          slot = &_slots[position & (_capacity - 1)];
+
+          const auto sequence   = slot->sequence.load(std::memory_order_acquire);
+          const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+          if (difference == 0)
+          {
+            if (_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+          }
+          else if (difference < 0) _ktz_impl_UNLIKELY // queue is full
+          {
+            switch (_policy)
+            {
+              case Backpressure::drop_newest:
+                _drop(size_);
+                return;
+
+              case Backpressure::spill:
+              {
+                {
+                  std::lock_guard<std::mutex> lock(_spill_mtx);
+                  _fallback->write(data_, size_);
+                }
+                spilled_lines.fetch_add(1, std::memory_order_relaxed);
+                spilled_bytes.fetch_add(size_, std::memory_order_relaxed);
+                _spilled.store(true, std::memory_order_release);
+                return;
+              }
+
+              case Backpressure::overwrite_oldest:
+                if (not _overwrite(*slot, position)) std::this_thread::yield();
+                break;
+
+              case Backpressure::block:
+              default:
+                std::this_thread::yield();
+                break;
+            }
+
+            position = _enqueue.load(std::memory_order_relaxed);
+          }
+          else
+          {
+            position = _enqueue.load(std::memory_order_relaxed);
+          }
+        }
+
+        slot->size = size_;
+        if (size_ <= sizeof(slot->text)) _ktz_impl_LIKELY
+        {
+          std::memcpy(slot->text, data_, size_);
+        }
+        else
+        {
+          slot->heap = new char[size_];
+          std::memcpy(slot->heap, data_, size_);
+        }
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+      }
+
+    private:
+      struct _slot
+      {
+        std::atomic<size_t> sequence;
+        size_t              size;
+        char*               heap = nullptr;
+        char                text[_ktz_impl_MAX_LEN];
+      };
+
+      static constexpr size_t _claimed = ~static_cast<size_t>(0); // sequence of a slot being written by _drain
+
+      const size_t                     _capacity;
+      const std::unique_ptr<_slot[]>   _slots;
+      Sink* const                      _sink;
+      const Backpressure               _policy;
+      Sink* const                      _fallback;  // destination of spilled lines
+      const std::unique_ptr<char[]>    _staging;   // batch copied out of the queue when overwriting
+      std::mutex                       _spill_mtx; // serializes spilled lines
+      std::atomic<bool>                _spilled  = {false}; // _fallback was written since its last flush
+      std::atomic<size_t>              _enqueue  = {0};
+      char                             _padding[64]; // keep producers and consumer on separate cache lines
+      std::atomic<size_t>              _dequeue  = {0};
+      std::atomic<size_t>              _flushed  = {0}; // lines written and flushed so far
+      std::atomic<bool>                _running  = {true};
+      std::thread                      _thread;
+
+      static
+      size_t _round_up(const unsigned capacity_) noexcept
+      {
+        size_t capacity = 2;
+        while (capacity < capacity_) capacity *= 2;
+        return capacity;
+      }
+
+      void _drop(const size_t size_) noexcept
+      {
+        dropped_lines.fetch_add(1, std::memory_order_relaxed);
+        dropped_bytes.fetch_add(size_, std::memory_order_relaxed);
+      }
+
+      // discard the oldest line of a full queue, freeing its slot for 'position', false if it could not
+      bool _overwrite(_slot& slot_, const size_t position_) noexcept
+      {
+        size_t sequence = position_ - _capacity + 1;
+
+        // the writer may be copying the line out
+        if (not slot_.sequence.compare_exchange_strong(sequence, 0, std::memory_order_acquire)) return false;
+
+        _drop(slot_.size);
+        delete[] slot_.heap;
+        slot_.heap = nullptr;
+
+        slot_.sequence.store(position_, std::memory_order_release);
+        return true;
+      }
+
+      // write every available line in batches, return how many were written
+      size_t _drain() noexcept
+      {
+        Sink::Line lines[_ktz_impl_BATCH_LEN];
+        size_t     count    = 0;
+        size_t     position = _dequeue.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+          size_t batch = 0;
+
+          for (; batch < _ktz_impl_BATCH_LEN; ++batch)
+          {
+            _slot& slot     = _slots[(position + batch) & (_capacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence != position + batch + 1) break;
+
+            // producers may overwrite the oldest line, claim it before reading it
+            if (_policy == Backpressure::overwrite_oldest
+              and not slot.sequence.compare_exchange_strong(sequence, _claimed, std::memory_order_acquire)) break;
+
+            lines[batch] = {slot.heap ? slot.heap : slot.text, slot.size};
+          }
+
+          if (batch == 0)
+          {
+            const auto ahead = static_cast<std::ptrdiff_t>(
+              _slots[position & (_capacity - 1)].sequence.load(std::memory_order_acquire) - (position + 1));
+
+            // a producer overwrote this line and already reused its slot for a later position
+            if (ahead > 0) _ktz_impl_UNLIKELY
+            {
+              _dequeue.store(++position, std::memory_order_release);
+              continue;
+            }
+
+            break;
+          }
+
+          if (_policy == Backpressure::overwrite_oldest) _ktz_impl_UNLIKELY
+          {
+            // copy the batch out first, producers keep overwriting the oldest lines during the write
+            char* heaps[_ktz_impl_BATCH_LEN];
+
+            for (size_t k = 0; k < batch; ++k, ++position)
+            {
+              _slot& slot = _slots[position & (_capacity - 1)];
+
+              heaps[k] = slot.heap;
+              if (slot.heap == nullptr)
+              {
+                lines[k].data = static_cast<char*>(std::memcpy(_staging.get() + k*_ktz_impl_MAX_LEN, slot.text, slot.size));
+              }
+
+              slot.heap = nullptr;
+              slot.sequence.store(position + _capacity, std::memory_order_release);
+            }
+
+            _dequeue.store(position, std::memory_order_release);
+            _sink->write_lines(lines, batch);
+            _written(lines, batch);
+
+            for (size_t k = 0; k < batch; ++k)
+            {
+              delete[] heaps[k];
+            }
+
+            count += batch;
+            continue;
+          }
+
+          _sink->write_lines(lines, batch);
+          _written(lines, batch);
+
+          for (size_t k = 0; k < batch; ++k, ++position)
+          {
+            _slot& slot = _slots[position & (_capacity - 1)];
+
+            delete[] slot.heap;
+            slot.heap = nullptr;
+
+            slot.sequence.store(position + _capacity, std::memory_order_release);
+          }
+
+          _dequeue.store(position, std::memory_order_release);
+          count += batch;
+        }
+
+        return count;
+      }
+
+      // count lines handed to _sink
+      void _written(const Sink::Line* const lines_, const size_t count_) noexcept
+      {
+        size_t size = 0;
+        for (size_t k = 0; k < count_; ++k) size += lines_[k].size;
+
+        written_lines.fetch_add(count_, std::memory_order_relaxed);
+        written_bytes.fetch_add(size, std::memory_order_relaxed);
+      }
+
+      // flush _fallback after lines were spilled, as _sink is after each batch
+      void _flush_spilled() noexcept
+      {
+        if (_spilled.load(std::memory_order_relaxed) and _spilled.exchange(false, std::memory_order_acquire))
+        {
+          std::lock_guard<std::mutex> lock(_spill_mtx);
+          _fallback->flush();
+        }
+      }
+
+      void _run() noexcept
+      {
+        unsigned idle = 0;
+
+        while (_running.load(std::memory_order_acquire))
+        {
+          _flush_spilled();
+
+          if (_drain())
+          {
+            _sink->flush();
+            flushes.fetch_add(1, std::memory_order_relaxed);
+            _flushed.store(_dequeue.load(std::memory_order_relaxed), std::memory_order_release);
+            idle = 0;
+          }
+          else if (++idle < 64)
+          {
+            std::this_thread::yield();
+          }
+          else
+          {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+        }
+
+        _drain();
+        _sink->flush();
+        _flush_spilled();
+        _flushed.store(_dequeue.load(std::memory_order_relaxed), std::memory_order_release);
+      }
+    };
+# else
+    class _async_writer final
+    {
+    public:
+      size_t             dropped_lines = 0;
+      size_t             dropped_bytes = 0;
+      size_t             spilled_lines = 0;
+      size_t             spilled_bytes = 0;
+      unsigned long long flushes       = 0;
+      unsigned long long written_lines = 0;
+      unsigned long long written_bytes = 0;
+
+      auto queued() const noexcept -> size_t { return 0; }
+      void push(const char*, size_t) noexcept {}
+      void wait() noexcept {}
+      void salvage() noexcept {}
+    };
+# endif
+
+# if defined(_ktz_impl_POSIX)
+    // write(2) until everything is written, async-signal-safe
+    inline bool _write_all(const int fd_, const char* data_, size_t size_) noexcept
+    {
+      while (size_ and fd_ >= 0)
+      {
+        const ssize_t count = ::write(fd_, data_, size_);
+        if (count < 0) _ktz_impl_UNLIKELY
+        {
+          return false;
+        }
+
+        data_ += count;
+        size_ -= static_cast<size_t>(count);
+      }
+
+      return fd_ >= 0;
+    }
+
+    // writev(2) until every line is written, async-signal-safe
+    inline bool _write_all(const int fd_, const Sink::Line* lines_, size_t count_) noexcept
+    {
+      iovec vectors[_ktz_impl_BATCH_LEN];
+
+      while (count_ and fd_ >= 0)
+      {
+        const size_t n_vectors = std::min(count_, static_cast<size_t>(_ktz_impl_BATCH_LEN));
+
+        for (size_t k = 0; k < n_vectors; ++k)
+        {
+          vectors[k] = {const_cast<char*>(lines_[k].data), lines_[k].size};
+        }
+
+        ssize_t count = ::writev(fd_, vectors, static_cast<int>(n_vectors));
+        if (count < 0) _ktz_impl_UNLIKELY
+        {
+          return false;
+        }
+
+        // skip the lines written entirely and finish a partially written one
+        size_t k = 0;
+        for (; k < n_vectors and static_cast<size_t>(count) >= lines_[k].size; ++k)
+        {
+          count -= static_cast<ssize_t>(lines_[k].size);
+        }
+
+        if (k < n_vectors)
+        {
+          const size_t done = static_cast<size_t>(count);
+          if (not _write_all(fd_, lines_[k].data + done, lines_[k].size - done)) return false;
+          ++k;
+        }
+
+        lines_ += k;
+        count_ -= k;
+      }
+
+      return fd_ >= 0;
+    }
+
+    // index following the highest existing 'path'.N, so that a restarted process never overwrites earlier files
+    inline auto _next_index(const std::string& path_) noexcept -> unsigned
+    {
+      const size_t      slash     = path_.rfind('/');
+      const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+      const std::string prefix    = (slash == std::string::npos ? path_ : path_.substr(slash + 1)) + '.';
+
+      DIR* const stream = ::opendir(directory.c_str());
+      if (stream == nullptr) _ktz_impl_UNLIKELY
+      {
+        return 0;
+      }
+
+      unsigned next = 0;
+
+      while (const dirent* const entry = ::readdir(stream))
+      {
+        if (std::strncmp(entry->d_name, prefix.c_str(), prefix.size()) != 0) continue;
+
+        const char* digits = entry->d_name + prefix.size();
+        if (*digits == '\0') continue;
+
+        unsigned long long index = 0;
+        for (; *digits >= '0' and *digits <= '9' and index < ~0U; ++digits)
+        {
+          index = 10*index + static_cast<unsigned>(*digits - '0');
+        }
+
+        if (*digits == '\0' and index < ~0U)
+        {
+          next = std::max(next, static_cast<unsigned>(index) + 1);
+        }
+      }
+
+      ::closedir(stream);
+
+      return next;
+    }
+# endif
+
+    // adapts the streambuf of an ostream to the Sink interface
+    class _ostream_sink final : public Sink
+    {
+    public:
+      _ostream_sink(std::streambuf* const buffer_) noexcept :
+        _buffer(buffer_),
+        _fd(buffer_ == std::cout.rdbuf() ? 1 : buffer_ == std::cerr.rdbuf() or buffer_ == std::clog.rdbuf() ? 2 : -1)
+      {}
+
+      void write(const char* const data_, const size_t size_) noexcept override
+      {
+        _buffer->sputn(data_, static_cast<std::streamsize>(size_));
+      }
+
+      void flush() noexcept override
+      {
+        _buffer->pubsync();
+      }
+
+      // only the standard streams have a known file descriptor
+      void salvage(const char* const data_, const size_t size_) noexcept override
+      {
+#     if defined(_ktz_impl_POSIX)
+        _write_all(_fd, data_, size_);
+#     endif
+      }
+
+    private:
+      std::streambuf* const _buffer;
+      const int             _fd; // file descriptor behind _buffer, -1 if unknown
+    };
+
+    // hands the same lines to several sinks
+    class _fan_out final : public Sink
+    {
+    public:
+      _fan_out(const std::initializer_list<Sink*> sinks_) noexcept :
+        _sinks(sinks_)
+      {}
+
+      void write(const char* const data_, const size_t size_) noexcept override
+      {
+        for (Sink* const sink : _sinks) sink->write(data_, size_);
+      }
+
+      void write_lines(const Line* const lines_, const size_t count_) noexcept override
+      {
+        for (Sink* const sink : _sinks) sink->write_lines(lines_, count_);
+      }
+
+      void flush() noexcept override
+      {
+        for (Sink* const sink : _sinks) sink->flush();
+      }
+
+      void salvage(const char* const data_, const size_t size_) noexcept override
+      {
+        for (Sink* const sink : _sinks) sink->salvage(data_, size_);
+      }
+
+    private:
+      const std::vector<Sink*> _sinks;
+    };
+
+    _ktz_impl_MAKE_SHARED_MUTEX(_interceptors_mtx)
+
+    class _interceptor final : public std::streambuf
+    {
+    public:
+      _interceptor(
+        Logger* const     stream_, std::ostream&     ostream_,
+        const char* const prefix_, const char* const suffix_
+      ) noexcept :
+        _ostream(&ostream_), _stream(stream_),
+        _prefix(prefix_),    _suffix(suffix_)
+      {
+        _enroll();
+      }
+
+      _interceptor(
+        Logger* const     stream_,
+        const char* const prefix_, const char* const suffix_
+      ) noexcept :
+        _ostream(stream_), _stream(stream_),
+        _prefix(prefix_),  _suffix(suffix_)
+      {
+        _enroll();
+      }
+
+      ~_interceptor() noexcept override
+      {
+        _ktz_impl_DECLARE_LOCK(_interceptors_mtx());
+        _live().erase(std::find(_live().begin(), _live().end(), this));
+      }
+
+      // give the ostream its buffer back, late writers holding this interceptor are forwarded to it too; a link made
+      // later on the same ostream, topmost or not, inherits the buffer so that it never restores this interceptor
+      void restore() noexcept
+      {
+        _ktz_impl_DECLARE_LOCK(_interceptors_mtx());
+
+        std::streambuf* const backup = _buffer_backup.load(std::memory_order_acquire);
+        _restored.store(true, std::memory_order_release);
+
+        for (_interceptor* const live : _live())
+        {
+          if (live->_buffer_backup.load(std::memory_order_relaxed) == this)
+          {
+            live->_buffer_backup.store(backup, std::memory_order_release);
+          }
+        }
+
+        if (_ostream->rdbuf() == this)
+        {
+          _ostream->rdbuf(backup);
+        }
+      }
+
+      auto id() const noexcept -> unsigned long long
+      {
+        return _id;
+      }
+
+      std::ostream* const    _ostream;
+    private:
+      // line being assembled by the calling thread
+      struct _pending
+      {
+        _interceptor*      owner = nullptr;
+        unsigned long long id    = 0;     // of the owner, tells a reused address apart
+        bool               open  = false; // its beginning, prefixes included, was already written by sync
+        std::string        text;
+      };
+
+      std::atomic<std::streambuf*> _buffer_backup = {_ostream->rdbuf()}; // spliced when an older link is restored
+      Logger* const                _stream;
+      _time_format                 _prefix;
+      _time_format                 _suffix;
+      const unsigned long long     _id = _unique_id();
+      std::atomic<bool>            _restored = {false};
+
+      static inline // interceptors not yet destroyed, guarded by _interceptors_mtx(), never destroyed itself
+      auto _live() noexcept -> std::vector<_interceptor*>&;
+
+      static inline // lines being assembled by the calling thread, _ktz_impl_PENDING_LINES of them
+      auto _lines() noexcept -> _pending*;
+
+      inline void _enroll() noexcept;
+      inline auto _find() noexcept -> _pending*;
+      inline auto _line() noexcept -> _pending&;
+      inline void _evict(_pending& line) noexcept;
+      inline void _commit(std::string& line) noexcept;
+      inline void _write(const std::string& text, unsigned long long lines) noexcept;
+      inline auto overflow(int_type character) -> int_type override;
+      inline auto xsputn(const char_type* data, std::streamsize size) -> std::streamsize override;
+      inline auto sync() -> int override;
+    };
+
+    _time_format::_time_format(const char* format_) noexcept :
+      _id(_unique_id())
+    {
+      for (const char* character = format_; *character; ++character)
+      {
+        if (*character != '%')
+        {
+          _text += *character;
+        }
+        else if (character[1] == '%')
+        {
+          _text += *++character;
+        }
+        else if (character[1] != '\0')
+        {
+          _format = format_;
+          _text.clear();
+          return;
+        }
+      }
+    }
+
+    void _time_format::render(std::string& line_) const noexcept
+    {
+      if (_format.empty()) _ktz_impl_LIKELY
+      {
+        line_ += _text;
+        return;
+      }
+
+      struct _cache
+      {
+        unsigned long long id     = 0;
+        std::time_t        second = -1;
+        std::string text;
+      };
+
+      // one timestamp per format a thread renders, evicted round-robin: a thread that alternates between more
+      // formats than _ktz_impl_TIME_FORMATS evicts each one before it comes back and reformats every line
+      static _ktz_impl_THREADLOCAL _cache    caches[_ktz_impl_TIME_FORMATS];
+      static _ktz_impl_THREADLOCAL unsigned victim = 0;
+
+      _cache* cache = nullptr;
+      for (auto& candidate : caches)
+      {
+        if (candidate.id == _id)
+        {
+          cache = &candidate;
+          break;
+        }
+      }
+
+      if (cache == nullptr) _ktz_impl_UNLIKELY
+      {
+        cache         = &caches[victim++ % _ktz_impl_TIME_FORMATS];
+        cache->id     = _id;
+        cache->second = -1;
+      }
+
+      const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+      if (now != cache->second) _ktz_impl_UNLIKELY
+      {
+        std::tm calendar;
+#     if defined(_WIN32)
+        localtime_s(&calendar, &now);
+#     else
+        localtime_r(&now, &calendar);
+#     endif
+
+        char buffer[_ktz_impl_MAX_LEN];
+#     pragma GCC diagnostic push
+#     pragma GCC diagnostic ignored "-Wformat-nonliteral"
+        cache->text.assign(buffer, std::strftime(buffer, sizeof(buffer), _format.c_str(), &calendar));
+#     pragma GCC diagnostic pop
+        cache->second = now;
+      }
+
+      line_ += cache->text;
+    }
+
+    inline // runtime threshold, messages below it are discarded before being formatted
+    auto _level() noexcept -> _ktz_impl_ATOMIC(unsigned char)&
+    {
+      static _ktz_impl_ATOMIC(unsigned char) level = {static_cast<unsigned char>(Level::trace)};
+      return level;
+    }
+
+    inline
+    bool _enabled(const Level level_) noexcept
+    {
+#   if defined(_ktz_impl_THREADSAFE)
+      return static_cast<unsigned char>(level_) >= _level().load(std::memory_order_relaxed);
+#   else
+      return static_cast<unsigned char>(level_) >= _level();
+#   endif
+    }
+
+    inline // start a log line with the level label and the caller
+    void _open_line(_text& text_, const Level level_, const char* const caller_) noexcept
+    {
+      static constexpr const char* labels[] = {"trace: ", "debug: ", "log: ", "warning: ", "error: ", ""};
+
+      text_.append(labels[static_cast<unsigned char>(level_)]);
+      text_.append(caller_);
+      text_.append(": ");
+    }
+
+    _ktz_impl_MAKE_SHARED_MUTEX(_loggers_mtx)
+
+    // live Loggers, also read without locking by _salvage
+    inline auto _loggers() noexcept -> _ktz_impl_ATOMIC(Logger*)(&)[_ktz_impl_MAX_LOGGERS]
+    {
+      static _ktz_impl_ATOMIC(Logger*) loggers[_ktz_impl_MAX_LOGGERS];
+      return loggers;
+    }
+
+    inline void _enlist(Logger* const logger_) noexcept
+    {
+      _ktz_impl_DECLARE_LOCK(_loggers_mtx());
+
+      for (auto& slot : _loggers())
+      {
+        if (slot == nullptr)
+        {
+          slot = logger_;
+          return;
+        }
+      }
+    }
+
+    inline void _dismiss(Logger* const logger_) noexcept
+    {
+      _ktz_impl_DECLARE_LOCK(_loggers_mtx());
+
+      for (auto& slot : _loggers())
+      {
+        if (slot == logger_)
+        {
+          slot = nullptr;
+          return;
+        }
+      }
+    }
+
+    void _flush_all() noexcept
+    {
+      _ktz_impl_DECLARE_LOCK(_loggers_mtx());
+
+      for (Logger* const logger : _loggers())
+      {
+        if (logger) logger->_flush_pending();
+      }
+    }
+
+    void _salvage() noexcept
+    {
+      static std::atomic_flag salvaged = ATOMIC_FLAG_INIT;
+
+      if (salvaged.test_and_set()) return;
+
+      for (Logger* const logger : _loggers())
+      {
+        if (logger == nullptr) continue;
+
+        if (logger->_async)
+        {
+          logger->_async->salvage();
+        }
+
+        logger->_sink->salvage(nullptr, 0);
+      }
+    }
+
+    inline // encoding of structured log lines
+    auto _encoding() noexcept -> _ktz_impl_ATOMIC(unsigned char)&
+    {
+      static _ktz_impl_ATOMIC(unsigned char) encoding = {static_cast<unsigned char>(Encoding::json)};
+      return encoding;
+    }
+
+    inline // preallocated per-thread buffer of structured log lines
+    auto _structured_text() noexcept -> _text&
+    {
+      static _ktz_impl_THREADLOCAL _text text;
+      text.clear();
+      return text;
+    }
+
+    inline // append quoted 'data' with JSON escapes, which logfmt readers accept as well
+    void _escape(_text& out_, const char* data_, const size_t size_) noexcept
+    {
+      // escape of each ASCII character, 'u' for \u00XX, 0 if written as is
+      static constexpr char escapes[128] = {
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+        'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+         0,   0,  '"',  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, '\\',  0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,  'u'
+      };
+
+      const char* const end = data_ + size_;
+
+      out_.push_back('"');
+
+      while (data_ != end)
+      {
+        // copy the longest run that needs no escaping at once
+        const char* run = data_;
+        while (run != end and (static_cast<unsigned char>(*run) >= 128 or not escapes[static_cast<unsigned char>(*run)]))
+        {
+          ++run;
+        }
+
+        out_.append(data_, static_cast<size_t>(run - data_));
+        if (run == end) break;
+
+        const auto character = static_cast<unsigned char>(*run);
+        const char escape    = escapes[character];
+
+        if (escape == 'u')
+        {
+          const char sequence[] = {'\\', 'u', '0', '0', "0123456789abcdef"[character >> 4], "0123456789abcdef"[character & 15]};
+          out_.append(sequence, sizeof(sequence));
+        }
+        else
+        {
+          const char sequence[] = {'\\', escape};
+          out_.append(sequence, sizeof(sequence));
+        }
+
+        data_ = run + 1;
+      }
+
+      out_.push_back('"');
+    }
+
+    inline // logfmt values are quoted only when they would be ambiguous
+    void _encode_string(_text& out_, const char* const data_, const size_t size_, const Encoding encoding_) noexcept
+    {
+      bool quote = encoding_ == Encoding::json or size_ == 0;
+
+      for (size_t k = 0; k < size_ and not quote; ++k)
+      {
+        const auto character = static_cast<unsigned char>(data_[k]);
+        quote = character <= ' ' or character == '=' or character == '"' or character == '\\' or character == 127;
+      }
+
+      if (quote)
+      {
+        _escape(out_, data_, size_);
+      }
+      else
+      {
+        out_.append(data_, size_);
+      }
+    }
+
+    inline
+    void _encode_value(_text& out_, const _arg& arg_, const Encoding encoding_) noexcept
+    {
+      switch (arg_.kind)
+      {
+        case _kind::integer:
+        {
+          char buffer[32];
+          char* const end   = buffer + sizeof(buffer);
+          char*       start = _digits(arg_.integer, 10, false, end);
+          if (arg_.negative) *--start = '-';
+          out_.append(start, static_cast<size_t>(end - start));
+          break;
+        }
+
+        case _kind::floating:
+        {
+          if (encoding_ == Encoding::json and not std::isfinite(arg_.floating))
+          {
+            out_.append("null", 4); // JSON has no representation for infinities and NaN
+            break;
+          }
+
+          _spec spec;
+          spec.precision  = 15;
+          spec.conversion = 'g';
+          _format_floating(out_, spec, arg_);
+          break;
+        }
+
+        case _kind::string:
+          _encode_string(out_, arg_.string.data, arg_.string.size, encoding_);
+          break;
+
+        case _kind::pointer:
+        {
+          char buffer[32];
+          char* const end   = buffer + sizeof(buffer);
+          char*       start = _digits(reinterpret_cast<uintptr_t>(arg_.pointer), 16, false, end);
+          *--start = 'x';
+          *--start = '0';
+          _encode_string(out_, start, static_cast<size_t>(end - start), encoding_);
+          break;
+        }
+
+        case _kind::none: _ktz_impl_UNLIKELY
+        default:
+          break;
+      }
+    }
+
+    inline
+    void _encode_value(_text& out_, const bool value_, const Encoding) noexcept
+    {
+      value_ ? out_.append("true", 4) : out_.append("false", 5);
+    }
+
+    template<typename T>
+    void _encode_value(_text& out_, const T& value_, const Encoding encoding_) noexcept
+    {
+      static_assert(_kind_of<T>() != _kind::none, "log: unsupported field type.");
+      _encode_value(out_, _make_arg(value_), encoding_);
+    }
+
+    inline
+    void _encode_key(_text& out_, const char* const key_, const Encoding encoding_) noexcept
+    {
+      if (encoding_ == Encoding::json)
+      {
+        out_.push_back(',');
+        _escape(out_, key_, std::strlen(key_));
+        out_.push_back(':');
+      }
+      else
+      {
+        out_.push_back(' ');
+        out_.append(key_);
+        out_.push_back('=');
+      }
+    }
+
+    inline
+    void _encode_fields(_text&, Encoding) noexcept
+    {}
+
+    template<typename K, typename V, typename... T>
+    void _encode_fields(_text& out_, const Encoding encoding_, const K& key_, const V& value_, const T&... fields_) noexcept
+    {
+      static_assert(std::is_convertible<K, const char*>::value, "log: keys must be strings.");
+
+      _encode_key(out_, key_, encoding_);
+      _encode_value(out_, value_, encoding_);
+      _encode_fields(out_, encoding_, fields_...);
+    }
+
+    inline // end a log line and write it to the stream of its level
+    void _close_line(_text& text_, const Level level_) noexcept
+    {
+      text_.push_back('\n');
+
+      const auto size = static_cast<std::streamsize>(text_.size());
+
+      switch (level_)
+      {
+        case Level::warning:
+        {
+          _ktz_impl_DECLARE_LOCK(_wrn_mtx);
+          _io::wrn.write(text_.data(), size).flush();
+          break;
+        }
+
+        case Level::error:
+        {
+          {
+            _ktz_impl_DECLARE_LOCK(_err_mtx);
+            _io::err.write(text_.data(), size).flush();
+          }
+
+          // the process may not survive the error, make sure buffered lines reach their destination
+          _flush_all();
+          break;
+        }
+
+        case Level::trace:
+        case Level::debug:
+        case Level::info:
+        case Level::off:
+        default:
+        {
+          _ktz_impl_DECLARE_LOCK(_log_mtx);
+          _io::log.write(text_.data(), size).flush();
+          break;
+        }
+      }
+    }
+
+    _ktz_impl_MAKE_SHARED_MUTEX(_spans_mtx)
+    _ktz_impl_MAKE_SHARED_MUTEX(_trace_mtx)
+
+    inline // whether scopes are being recorded
+    auto _tracing() noexcept -> std::atomic<bool>&
+    {
+      static std::atomic<bool> tracing = {false};
+      return tracing;
+    }
+
+    // scope timed by trace_span or indented_log
+    struct _span_event
+    {
+      const char*        name;  // string literal or format of a call site
+      unsigned long long begin; // nanoseconds of the steady clock
+      unsigned long long end;
+      unsigned           depth; // number of enclosing scopes on the same thread
+    };
+
+    // per-thread single-producer single-consumer ring of closed scopes, drained by write_trace
+    class _span_ring final
+    {
+    public:
+      const unsigned      tid;               // thread identifier shown in the trace
+      std::atomic<bool>   orphan  = {false}; // owning thread has exited
+      std::atomic<size_t> dropped = {0};     // scopes lost because the ring was full
+
+      _span_ring(const unsigned tid_) noexcept :
+        tid(tid_)
+      {}
+
+      static // ring of the calling thread
+      auto local() noexcept -> _span_ring&
+      {
+        struct _owner
+        {
+          _span_ring* const ring = _acquire();
+          ~_owner() noexcept { ring->orphan = true; }
+        };
+
+        static _ktz_impl_THREADLOCAL _owner owner;
+        return *owner.ring;
+      }
+
+      static // scopes currently open on the calling thread
+      auto depth() noexcept -> unsigned&
+      {
+        static _ktz_impl_THREADLOCAL unsigned depth = 0;
+        return depth;
+      }
+
+      static // every ring ever used
+      auto snapshot() noexcept -> std::vector<_span_ring*>
+      {
+        _ktz_impl_DECLARE_LOCK(_spans_mtx());
+
+        std::vector<_span_ring*> rings;
+        for (const auto& ring : _rings()) rings.push_back(ring.get());
+
+        return rings;
+      }
+
+      // producer
+      void push(const _span_event& event_) noexcept
+      {
+        const size_t head = _head.load(std::memory_order_relaxed);
+
+        if (head - _tail.load(std::memory_order_acquire) == _ktz_impl_TRACE_LEN) _ktz_impl_UNLIKELY
+        {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+
+        _events[head % _ktz_impl_TRACE_LEN] = event_;
+        _head.store(head + 1, std::memory_order_release);
+      }
+
+      // consumer: call 'consume(event)' for every available scope
+      template<typename C>
+      size_t drain(const C& consume_) noexcept
+      {
+        const size_t head = _head.load(std::memory_order_acquire);
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+
+        for (size_t k = tail; k != head; ++k)
+        {
+          consume_(_events[k % _ktz_impl_TRACE_LEN]);
+        }
+
+        _tail.store(head, std::memory_order_release);
+        return head - tail;
+      }
+
+    private:
+      const std::unique_ptr<_span_event[]> _events = std::unique_ptr<_span_event[]>(new _span_event[_ktz_impl_TRACE_LEN]);
+      std::atomic<size_t>                  _head   = {0};
+      char                                 _padding[64]; // keep producer and consumer on separate cache lines
+      std::atomic<size_t>                  _tail   = {0};
+
+      // every ring ever used, guarded by _spans_mtx()
+      static
+      auto _rings() noexcept -> std::vector<std::unique_ptr<_span_ring>>&
+      {
+        static std::vector<std::unique_ptr<_span_ring>> all;
+        return all;
+      }
+
+      static
+      auto _acquire() noexcept -> _span_ring*
+      {
+        _ktz_impl_DECLARE_LOCK(_spans_mtx());
+
+        // reuse the ring of an exited thread once it has been drained
+        for (auto& ring : _rings())
+        {
+          if (ring->orphan and ring->_head == ring->_tail)
+          {
+            ring->orphan = false;
+            return ring.get();
+          }
+        }
+
+        _rings().emplace_back(new _span_ring(static_cast<unsigned>(_rings().size() + 1)));
+        return _rings().back().get();
+      }
+    };
+
+    // records the enclosing scope on destruction, if tracing when constructed
+    class _span final
+    {
+    public:
+      _span(const char* const name_) noexcept :
+        _name(name_ and _tracing().load(std::memory_order_relaxed) ? name_ : nullptr),
+        _begin(_name ? _steady_ns() : 0)
+      {
+        if (_name) ++_span_ring::depth();
+      }
+
+      ~_span() noexcept
+      {
+        if (_name == nullptr) _ktz_impl_LIKELY
+        {
+          return;
+        }
+
+        const unsigned long long end = _steady_ns();
+        _span_ring::local().push({_name, _begin, end, --_span_ring::depth()});
+      }
+
+    private:
+      const char* const        _name; // nullptr if not recorded
+      const unsigned long long _begin;
+    };
+
+    inline // microseconds with nanosecond precision, as trace-event timestamps expect
+    void _append_microseconds(_text& out_, const unsigned long long nanoseconds_) noexcept
+    {
+      char buffer[32];
+      const int size = std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", nanoseconds_/1000, nanoseconds_%1000);
+      out_.append(buffer, static_cast<size_t>(size));
+    }
+
+    class _indented_log final
+    {
+    public:
+      template<typename F>
+      _indented_log(const F& format_, Site& site_, const char* const caller_) noexcept :
+        _active(site_.admit(caller_)),
+        _scope(_active ? site_.format : nullptr)
+      {
+        if (not _active) return;
+
+        _text text;
+        _open_line(text, Level::info, caller_);
+        text.append(_indentation(), ' ');
+        format_(text);
+        _close_line(text, Level::info);
+
+        _indentation() += 2;
+      }
+
+      ~_indented_log() noexcept
+      {
+        if (_active) _indentation() -= 2;
+      }
+
+    private:
+      const bool  _active;
+      const _span _scope; // timed while tracing
+
+      auto _indentation() -> _ktz_impl_ATOMIC(unsigned)&
+      {
+        static _ktz_impl_ATOMIC(unsigned) indentation = {0};
+        return indentation;
+      }
+    };
+
+    // per-call-site state of KTZ_RATE_LIMIT and KTZ_SAMPLE
+    class _throttle final
+    {
+    public:
+      constexpr _throttle() noexcept = default;
+
+      // token bucket kept as the time at which the bucket is full again (GCRA)
+      bool rate(const double rate_, const unsigned burst_, const char* const caller_) noexcept
+      {
+        const auto interval = static_cast<long long>(1e9/rate_);
+        const auto limit    = interval*static_cast<long long>(burst_ - 1);
+        const auto now      = _now();
+
+        auto full = _full.load(std::memory_order_relaxed);
+
+        do
+        {
+          if (std::max(full, now) - now > limit)
+          {
+            _suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+        } while (not _full.compare_exchange_weak(full, std::max(full, now) + interval, std::memory_order_relaxed));
+
+        _report(now, caller_);
+        return true;
+      }
+
+      bool sample(const unsigned long long n_, const char* const caller_) noexcept
+      {
+        if (_count.fetch_add(1, std::memory_order_relaxed) % n_)
+        {
+          _suppressed.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+
+        _report(_now(), caller_);
+        return true;
+      }
+
+    private:
+      std::atomic<long long>          _full       = {0};
+      std::atomic<unsigned long long> _count      = {0};
+      std::atomic<unsigned long long> _suppressed = {0};
+      std::atomic<long long>          _reported   = {0}; // time of the last summary
+
+      static
+      long long _now() noexcept
+      {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+      }
+
+      // suppressed calls are summarized along with an admitted one, at most once per second
+      void _report(const long long now_, const char* const caller_) noexcept
+      {
+        if (_suppressed.load(std::memory_order_relaxed) == 0) _ktz_impl_LIKELY return;
+
+        auto reported = _reported.load(std::memory_order_relaxed);
+        if (now_ - reported < 1000000000LL) return;
+        if (not _reported.compare_exchange_strong(reported, now_, std::memory_order_relaxed)) return;
+
+        const auto suppressed = _suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed == 0 or not _enabled(Level::warning)) return;
+
+        _text text;
+        _open_line(text, Level::warning, caller_);
+        _format(text, "%llu messages suppressed", suppressed);
+        _close_line(text, Level::warning);
+      }
+    };
+
+    // stands in for compiled-out indented_log scopes
+    struct _disabled final
+    {
+      _disabled(size_t) noexcept {}
+    };
+
+    _ktz_impl_MAKE_SHARED_MUTEX(_sites_mtx)
+    _ktz_impl_MAKE_SHARED_MUTEX(_call_sites_mtx)
+
+    // registered call sites, guarded by _call_sites_mtx()
+    inline auto _call_sites() noexcept -> std::vector<Site*>&
+    {
+      static std::vector<Site*> sites;
+      return sites;
+    }
+
+    // file patterns given to enable_sites in call order, applied to sites registering later, guarded by _call_sites_mtx()
+    inline auto _site_rules() noexcept -> std::vector<std::pair<std::string, bool>>&
+    {
+      static std::vector<std::pair<std::string, bool>> rules;
+      return rules;
+    }
+    _ktz_impl_MAKE_SHARED_MUTEX(_rings_mtx)
+    _ktz_impl_MAKE_SHARED_MUTEX(_drain_mtx)
+
+    // static description of a binary_log call site
+    class _binary_site final
+    {
+    public:
+      template<typename F, typename... T>
+      _binary_site(
+        _types<F, T...>, const char* const caller_, const char* const file_, const unsigned line_,
+        const char* const format_) noexcept :
+        format(format_), caller(caller_), file(file_), line(line_),
+        n_args(sizeof...(T)), kinds{_kind_of<T>()..., _kind::none}, id(_register(this))
+      {
+        static_assert(sizeof...(T) <= _ktz_impl_MAX_ARGS, "binary_log: too many arguments.");
+      }
+
+      const char* const format;
+      const char* const caller;
+      const char* const file;
+      const unsigned    line;
+      const unsigned    n_args;
+      const _kind       kinds[_ktz_impl_MAX_ARGS + 1];
+      const uint32_t    id;
+
+      // registered sites, indexed by id - 1
+      static
+      auto registry() noexcept -> std::vector<const _binary_site*>&
+      {
+        static std::vector<const _binary_site*> sites;
+        return sites;
+      }
+
+    private:
+      static
+      auto _register(const _binary_site* const site_) noexcept -> uint32_t
+      {
+        _ktz_impl_DECLARE_LOCK(_sites_mtx());
+        registry().push_back(site_);
+        return static_cast<uint32_t>(registry().size());
+      }
+    };
+
+    // per-thread single-producer single-consumer ring of encoded binary_log records
+    class _binary_ring final
+    {
+    public:
+      std::atomic<bool>   orphan  = {false}; // owning thread has exited
+      std::atomic<size_t> dropped = {0};     // records lost because the ring was full
+
+      // ring of the calling thread
+      static
+      auto local() noexcept -> _binary_ring&
+      {
+        struct _owner
+        {
+          _binary_ring* const ring = _acquire();
+          ~_owner() noexcept { ring->orphan = true; }
+        };
+
+        static _ktz_impl_THREADLOCAL _owner owner;
+        return *owner.ring;
+      }
+
+      // every ring ever used, guarded by _rings_mtx()
+      static
+      auto rings() noexcept -> std::vector<std::unique_ptr<_binary_ring>>&
+      {
+        static std::vector<std::unique_ptr<_binary_ring>> all;
+        return all;
+      }
+
+      // producer: reserve room for a record of 'size' bytes, false if the ring is full
+      bool reserve(const size_t size_, size_t& cursor_) noexcept
+      {
+        cursor_ = _head.load(std::memory_order_relaxed);
+
+        if (_ktz_impl_BINARY_LEN - (cursor_ - _tail.load(std::memory_order_acquire)) < size_) _ktz_impl_UNLIKELY
+        {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+
+        return true;
+      }
+
+      // producer: write part of the reserved record
+      void write(size_t& cursor_, const void* const data_, const size_t size_) noexcept
+      {
+        _copy_in(cursor_, static_cast<const char*>(data_), size_);
+        cursor_ += size_;
+      }
+
+      // producer: publish the record written up to 'cursor'
+      void commit(const size_t cursor_) noexcept
+      {
+        _head.store(cursor_, std::memory_order_release);
+      }
+
+      // consumer: call 'consume(id, payload, size)' for every available record
+      template<typename C>
+      size_t drain(const C& consume_) noexcept
+      {
+        const size_t head = _head.load(std::memory_order_acquire);
+        size_t       tail = _tail.load(std::memory_order_relaxed);
+        size_t       count = 0;
+        std::string  payload;
+
+        while (tail != head)
+        {
+          uint32_t header[2]; // site id, payload size
+          _copy_out(tail, reinterpret_cast<char*>(header), sizeof(header));
+          payload.resize(header[1]);
+          _copy_out(tail + sizeof(header), &payload[0], header[1]);
+          tail += sizeof(header) + header[1];
+
+          consume_(header[0], payload.data(), payload.size());
+          ++count;
+        }
+
+        _tail.store(tail, std::memory_order_release);
+        return count;
+      }
+
+    private:
+      const std::unique_ptr<char[]> _data     = std::unique_ptr<char[]>(new char[_ktz_impl_BINARY_LEN]);
+      std::atomic<size_t>           _head     = {0};
+      char                          _padding[64]; // keep producer and consumer on separate cache lines
+      std::atomic<size_t>           _tail     = {0};
+
+      static
+      auto _acquire() noexcept -> _binary_ring*
+      {
+        _ktz_impl_DECLARE_LOCK(_rings_mtx());
+
+        // reuse the ring of an exited thread once it has been drained
+        for (auto& ring : rings())
+        {
+          if (ring->orphan and ring->_head == ring->_tail)
+          {
+            ring->orphan = false;
+            return ring.get();
+          }
+        }
+
+        rings().emplace_back(new _binary_ring);
+        return rings().back().get();
+      }
+
+      void _copy_in(const size_t position_, const char* const data_, const size_t size_) noexcept
+      {
+        const size_t offset = position_ % _ktz_impl_BINARY_LEN;
+        const size_t first  = std::min(size_, _ktz_impl_BINARY_LEN - offset);
+        std::memcpy(_data.get() + offset, data_, first);
+        std::memcpy(_data.get(), data_ + first, size_ - first);
+      }
+
+      void _copy_out(const size_t position_, char* const data_, const size_t size_) const noexcept
+      {
+        const size_t offset = position_ % _ktz_impl_BINARY_LEN;
+        const size_t first  = std::min(size_, _ktz_impl_BINARY_LEN - offset);
+        std::memcpy(data_, _data.get() + offset, first);
+        std::memcpy(data_ + first, _data.get(), size_ - first);
+      }
+    };
+
+    inline // size of an argument once encoded
+    auto _encoded_size(const _arg& arg_) noexcept -> size_t
+    {
+      switch (arg_.kind)
+      {
+        case _kind::integer:  return 1 + sizeof(unsigned long long);
+        case _kind::floating: return sizeof(double);
+        case _kind::pointer:  return sizeof(unsigned long long);
+        case _kind::string:   return sizeof(uint32_t) + arg_.string.size;
+        case _kind::none: _ktz_impl_UNLIKELY
+        default:              return 0;
+      }
+    }
+
+    inline
+    void _encode(const _arg& arg_, _binary_ring& ring_, size_t& cursor_) noexcept
+    {
+      switch (arg_.kind)
+      {
+        case _kind::integer:
+        {
+          const unsigned char sign_size = static_cast<unsigned char>(arg_.negative | arg_.size << 1);
+          ring_.write(cursor_, &sign_size, 1);
+          ring_.write(cursor_, &arg_.integer, sizeof(arg_.integer));
+          break;
+        }
+
+        case _kind::floating:
+          ring_.write(cursor_, &arg_.floating, sizeof(arg_.floating));
+          break;
+
+        case _kind::pointer:
+        {
+          const auto pointer = static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(arg_.pointer));
+          ring_.write(cursor_, &pointer, sizeof(pointer));
+          break;
+        }
+
+        case _kind::string:
+        {
+          const auto size = static_cast<uint32_t>(arg_.string.size);
+          ring_.write(cursor_, &size, sizeof(size));
+          ring_.write(cursor_, arg_.string.data, arg_.string.size);
+          break;
+        }
+
+        case _kind::none: _ktz_impl_UNLIKELY
+        default:
+          break;
+      }
+    }
+
+    inline // decode 'n_args' arguments of 'kinds' from 'payload', false if the payload is malformed
+    bool _decode(
+      const char* payload_, const size_t size_, const _kind* const kinds_, const unsigned n_args_, _arg* const args_
+    ) noexcept
+    {
+      const char* const end = payload_ + size_;
+
+      for (unsigned k = 0; k < n_args_; ++k)
+      {
+        _arg& arg   = args_[k];
+        arg.kind     = kinds_[k];
+        arg.negative = false;
+        arg.size     = 0;
+
+        switch (kinds_[k])
+        {
+          case _kind::integer:
+            if (end - payload_ < static_cast<std::ptrdiff_t>(1 + sizeof(arg.integer))) return false;
+            arg.negative = *payload_ & 1; // then the size, absent from older dumps
+            arg.size     = static_cast<unsigned char>(static_cast<unsigned char>(*payload_++) >> 1);
+            std::memcpy(&arg.integer, payload_, sizeof(arg.integer));
+            payload_ += sizeof(arg.integer);
+            break;
+
+          case _kind::floating:
+            if (end - payload_ < static_cast<std::ptrdiff_t>(sizeof(arg.floating))) return false;
+            std::memcpy(&arg.floating, payload_, sizeof(arg.floating));
+            arg.negative = std::signbit(arg.floating);
+            payload_ += sizeof(arg.floating);
+            break;
+
+          case _kind::pointer:
+          {
+            unsigned long long pointer;
+            if (end - payload_ < static_cast<std::ptrdiff_t>(sizeof(pointer))) return false;
+            std::memcpy(&pointer, payload_, sizeof(pointer));
+            arg.pointer = reinterpret_cast<const void*>(static_cast<uintptr_t>(pointer));
+            payload_ += sizeof(pointer);
+            break;
+          }
+
+          case _kind::string:
+          {
+            uint32_t length;
+            if (end - payload_ < static_cast<std::ptrdiff_t>(sizeof(length))) return false;
+            std::memcpy(&length, payload_, sizeof(length));
+            payload_ += sizeof(length);
+            if (end - payload_ < static_cast<std::ptrdiff_t>(length)) return false;
+            arg.string.data = payload_;
+            arg.string.size = length;
+            payload_ += length;
+            break;
+          }
+
+          case _kind::none: _ktz_impl_UNLIKELY
+          default:
+            return false;
+        }
+      }
+
+      return true;
+    }
+
+    inline // format a decoded record as a log line
+    void _render_record(
+      _text& out_, const char* const caller_, const char* const format_,
+      const char* const payload_, const size_t size_, const _kind* const kinds_, const unsigned n_args_
+    ) noexcept
+    {
+      _arg args[_ktz_impl_MAX_ARGS + 1];
+
+      out_.append("log: ");
+      out_.append(caller_);
+      out_.append(": ");
+
+      if (_decode(payload_, size_, kinds_, n_args_, args)) _ktz_impl_LIKELY
+      {
+        _vformat(out_, format_, args, n_args_);
+      }
+      else
+      {
+        out_.append("<malformed record>");
+      }
+
+      out_.push_back('\n');
+    }
+
+    template<typename... T>
+    void _binary_log(const _binary_site& site_, const char* const, const T&... args_) noexcept
+    {
+      const _arg args[] = {_make_arg(args_)..., _arg()};
+
+      uint32_t header[2] = {site_.id, 0};
+      for (size_t k = 0; k < sizeof...(T); ++k)
+      {
+        header[1] += static_cast<uint32_t>(_encoded_size(args[k]));
+      }
+
+      auto&  ring   = _binary_ring::local();
+      size_t cursor;
+
+      if (ring.reserve(sizeof(header) + header[1], cursor)) _ktz_impl_LIKELY
+      {
+        ring.write(cursor, header, sizeof(header));
+        for (size_t k = 0; k < sizeof...(T); ++k) _encode(args[k], ring, cursor);
+        ring.commit(cursor);
+      }
+    }
+
+    inline void _log(...) noexcept {}
+  }
+
+# define _ktz_impl_LOG_ENABLED(LEVEL, NAME, ...)                         \
+    [&](const char* const caller_){                                     \
+      _ktz_impl_CHECK_FORMAT(NAME, __VA_ARGS__);                         \
+      static ktz::Site call_site(                                        \
+        __FILE__, __LINE__, _ktz_impl_FORMAT_OF(__VA_ARGS__, ~), LEVEL); \
+      if (not call_site.admit(caller_)) return;                          \
+      ktz::_impl::_text text;                                            \
+      ktz::_impl::_open_line(text, LEVEL, caller_);                      \
+      ktz::_impl::_format(text, __VA_ARGS__);                            \
+      ktz::_impl::_close_line(text, LEVEL);                              \
+    }(__func__)
+# define _ktz_impl_LOG_DISABLED(...) static_cast<void>(sizeof(ktz::_impl::_types_of(__VA_ARGS__)))
+
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_TRACE
+# define _ktz_impl_LOG_trace(NAME, ...) _ktz_impl_LOG_ENABLED(ktz::Level::trace, NAME, __VA_ARGS__)
+#else
+# define _ktz_impl_LOG_trace(NAME, ...) _ktz_impl_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_DEBUG
+# define _ktz_impl_LOG_debug(NAME, ...) _ktz_impl_LOG_ENABLED(ktz::Level::debug, NAME, __VA_ARGS__)
+#else
+# define _ktz_impl_LOG_debug(NAME, ...) _ktz_impl_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_INFO
+# define _ktz_impl_LOG_info(NAME, ...)  _ktz_impl_LOG_ENABLED(ktz::Level::info, NAME, __VA_ARGS__)
+#else
+# define _ktz_impl_LOG_info(NAME, ...)  _ktz_impl_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_WARNING
+# define _ktz_impl_LOG_warning(NAME, ...) _ktz_impl_LOG_ENABLED(ktz::Level::warning, NAME, __VA_ARGS__)
+#else
+# define _ktz_impl_LOG_warning(NAME, ...) _ktz_impl_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_ERROR
+# define _ktz_impl_LOG_error(NAME, ...) _ktz_impl_LOG_ENABLED(ktz::Level::error, NAME, __VA_ARGS__)
+#else
+# define _ktz_impl_LOG_error(NAME, ...) _ktz_impl_LOG_DISABLED(__VA_ARGS__)
+#endif
+
+# undef  KTZ_LOG
+# define KTZ_LOG(LEVEL, ...) _ktz_impl_LOG_##LEVEL("KTZ_LOG", __VA_ARGS__)
+
+# undef  log_message
+# define log_message(...) _impl::_log((_ktz_impl_LOG_info("log_message", __VA_ARGS__), 0))
+
+# undef  indented_log
+# define indented_log(...)              _ktz_impl_ILOG_PRXY(__LINE__,    __VA_ARGS__)
+# define _ktz_impl_ILOG_PRXY(LINE, ...) _ktz_impl_ILOG_IMPL(LINE,        __VA_ARGS__)
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_INFO
+# define _ktz_impl_ILOG_IMPL(LINE, ...)                        \
+    _impl::_indented_log _ilg_##LINE([&](ktz::_impl::_text& text_){ \
+      using namespace ktz;                                     \
+      _ktz_impl_CHECK_FORMAT("indented_log", __VA_ARGS__);      \
+      _impl::_format(text_, __VA_ARGS__);                      \
+    }, []() -> ktz::Site& {                                    \
+      static ktz::Site call_site(                              \
+        __FILE__, __LINE__, _ktz_impl_FORMAT_OF(__VA_ARGS__, ~), ktz::Level::info); \
+      return call_site;                                        \
+    }(), __func__)
+#else
+# define _ktz_impl_ILOG_IMPL(LINE, ...) \
+    _impl::_disabled _ilg_##LINE(sizeof(ktz::_impl::_types_of(__VA_ARGS__)))
+#endif
+
+# undef  trace_span
+# define trace_span(NAME)                 _ktz_impl_SPAN_PRXY(__LINE__, NAME)
+# define _ktz_impl_SPAN_PRXY(LINE, NAME)  _ktz_impl_SPAN_IMPL(LINE, NAME)
+# define _ktz_impl_SPAN_IMPL(LINE, NAME)  _impl::_span _spn_##LINE("" NAME "")
+
+# undef  KTZ_WARNING
+# define KTZ_WARNING(...) _ktz_impl_LOG_warning("KTZ_WARNING", __VA_ARGS__)
+
+# undef  KTZ_ERROR
+# define KTZ_ERROR(return_value, ...) return _ktz_impl_LOG_error("KTZ_ERROR", __VA_ARGS__), return_value
+
+# undef  KTZ_RATE_LIMIT
+# define KTZ_RATE_LIMIT(RATE, BURST)                                                      \
+    if (not [](const char* const caller_){                                               \
+      static_assert((RATE) > 0, "KTZ_RATE_LIMIT: 'RATE' must be a positive number.");    \
+      static_assert((BURST) > 0, "KTZ_RATE_LIMIT: 'BURST' must be a positive number.");  \
+      static ktz::_impl::_throttle throttle;                                             \
+      return throttle.rate(RATE, BURST, caller_);                                        \
+    }(__func__)) {} else
+
+# undef  KTZ_SAMPLE
+# define KTZ_SAMPLE(N)                                                                   \
+    if (not [](const char* const caller_){                                               \
+      static_assert((N) > 0, "KTZ_SAMPLE: 'N' must be a non-zero positive number.");     \
+      static ktz::_impl::_throttle throttle;                                             \
+      return throttle.sample(N, caller_);                                                \
+    }(__func__)) {} else
+
+# undef  binary_log
+#if KTZ_MIN_LEVEL <= KTZ_LEVEL_INFO
+# define binary_log(...)                                                        \
+    _impl::_log(([&](const char* const caller_){                                \
+      using namespace ktz;                                                      \
+      _ktz_impl_CHECK_FORMAT("binary_log", __VA_ARGS__);                         \
+      static Site call_site(                                                    \
+        __FILE__, __LINE__, _ktz_impl_FORMAT_OF(__VA_ARGS__, ~), Level::info);  \
+      if (not call_site.admit(caller_)) return;                                 \
+      static const _impl::_binary_site site(                                    \
+        decltype(_impl::_types_of(__VA_ARGS__))(), caller_, __FILE__, __LINE__, \
+        _ktz_impl_FORMAT_OF(__VA_ARGS__, ~));                                   \
+      _impl::_binary_log(site, __VA_ARGS__);                                    \
+    }(__func__), 0))
+#else
+# define binary_log(...) _impl::_log((_ktz_impl_LOG_DISABLED(__VA_ARGS__), 0))
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+  void set_level(const Level level_) noexcept
+  {
+    _impl::_level() = static_cast<unsigned char>(level_);
+  }
+
+  auto get_level() noexcept -> Level
+  {
+    return static_cast<Level>(static_cast<unsigned char>(_impl::_level()));
+  }
+
+  constexpr Site::Site(const char* const file_, const unsigned line_, const char* const format_, const Level level_) noexcept :
+    file(file_), line(line_), format(format_), level(level_)
+  {}
+
+  auto Site::function() const noexcept -> const char*
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_call_sites_mtx());
+    return _function;
+  }
+
+  void Site::enable(const bool enabled_) noexcept
+  {
+    _state.store(enabled_ ? _forced_on : _forced_off, std::memory_order_relaxed);
+  }
+
+  void Site::reset() noexcept
+  {
+    _state.store(_default, std::memory_order_relaxed);
+  }
+
+  bool Site::enabled() const noexcept
+  {
+    const auto state = _state.load(std::memory_order_relaxed);
+    return state == _forced_on or ((state == _default or state == _unregistered) and _impl::_enabled(level));
+  }
+
+  bool Site::admit(const char* const function_) noexcept
+  {
+    const auto state = _state.load(std::memory_order_relaxed);
+
+    if (state == _default) _ktz_impl_LIKELY
+    {
+      return _impl::_enabled(level);
+    }
+
+    if (state == _unregistered) _ktz_impl_UNLIKELY
+    {
+      return _register(function_);
+    }
+
+    return state == _forced_on;
+  }
+
+  bool Site::_register(const char* const function_) noexcept
+  {
+    {
+      _ktz_impl_DECLARE_LOCK(_impl::_call_sites_mtx());
+
+      if (_state.load(std::memory_order_relaxed) == _unregistered)
+      {
+        _function = function_;
+        _impl::_call_sites().push_back(this);
+
+        // the latest enable_sites call whose pattern matches decides
+        unsigned char state = _default;
+        for (const auto& rule : _impl::_site_rules())
+        {
+          if (std::strstr(file, rule.first.c_str())) state = rule.second ? _forced_on : _forced_off;
+        }
+
+        _state.store(state, std::memory_order_relaxed);
+      }
+    }
+
+    return admit(function_);
+  }
+
+  auto sites() noexcept -> std::vector<Site*>
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_call_sites_mtx());
+    return _impl::_call_sites();
+  }
+
+  auto enable_sites(const char* const file_, const bool enabled_) noexcept -> size_t
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_call_sites_mtx());
+
+    // remembered for the sites that have not run yet, a repeated pattern moves to the end with its new setting
+    auto& rules = _impl::_site_rules();
+    rules.erase(std::remove_if(rules.begin(), rules.end(),
+      [file_](const std::pair<std::string, bool>& rule_){ return rule_.first == file_; }), rules.end());
+    rules.emplace_back(file_, enabled_);
+
+    size_t count = 0;
+    for (Site* const site : _impl::_call_sites())
+    {
+      if (std::strstr(site->file, file_))
+      {
+        site->enable(enabled_);
+        ++count;
+      }
+    }
+
+    return count;
+  }
+
+  void set_encoding(const Encoding encoding_) noexcept
+  {
+    _impl::_encoding() = static_cast<unsigned char>(encoding_);
+  }
+
+  template<typename... T>
+  void log(const Level level_, const char* const message_, const T&... fields_) noexcept
+  {
+    static_assert(sizeof...(T) % 2 == 0, "log: fields must be key, value pairs.");
+
+#if KTZ_MIN_LEVEL > KTZ_LEVEL_TRACE
+    if (static_cast<unsigned char>(level_) < KTZ_MIN_LEVEL) return;
+#endif
+    if (not _impl::_enabled(level_)) return;
+
+    static constexpr const char* levels[] = {"trace", "debug", "info", "warning", "error", "off"};
+
+    const auto   encoding = static_cast<Encoding>(static_cast<unsigned char>(_impl::_encoding()));
+    _impl::_text& text    = _impl::_structured_text();
+
+    if (encoding == Encoding::json)
+    {
+      text.append("{\"level\":\"", 10);
+      text.append(levels[static_cast<unsigned char>(level_)]);
+      text.append("\",\"msg\":", 8);
+      _impl::_escape(text, message_, std::strlen(message_));
+      _impl::_encode_fields(text, encoding, fields_...);
+      text.push_back('}');
+    }
+    else
+    {
+      text.append("level=", 6);
+      text.append(levels[static_cast<unsigned char>(level_)]);
+      text.append(" msg=", 5);
+      _impl::_encode_string(text, message_, std::strlen(message_), encoding);
+      _impl::_encode_fields(text, encoding, fields_...);
+    }
+
+    _impl::_close_line(text, level_);
+  }
+
+# if defined(_ktz_impl_POSIX)
+  namespace _impl
+  {
+    // dispositions replaced by flush_on_crash, restored before the signal is raised again
+    inline auto _previous_actions() noexcept -> struct sigaction(&)[NSIG]
+    {
+      static struct sigaction actions[NSIG];
+      return actions;
+    }
+
+    inline void _on_crash(const int signal_) noexcept
+    {
+      _salvage();
+
+      ::sigaction(signal_, &_previous_actions()[signal_], nullptr);
+      ::raise(signal_);
+    }
+  }
+
+  void flush_on_crash() noexcept
+  {
+    static const bool installed _ktz_impl_MAYBE_UNUSED = []{
+      for (const int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM})
+      {
+        struct sigaction action = {};
+        action.sa_handler = _impl::_on_crash;
+        sigemptyset(&action.sa_mask);
+
+        ::sigaction(signal, &action, &_impl::_previous_actions()[signal]);
+      }
+
+      return true;
+    }();
+  }
+# else
+  void flush_on_crash() noexcept
+  {}
+# endif
+
+  void register_thread() noexcept
+  {
+    _impl::_epoch::enter();
+  }
+//----------------------------------------------------------------------------------------------------------------------
+  Logger::Logger(const std::ostream& ostream_, const char* const prefix_, const char* const suffix_) noexcept :
+    Logger(*new _impl::_ostream_sink(ostream_.rdbuf()), prefix_, suffix_)
+  {
+    _owned_sink.reset(_sink);
+  }
+
+  Logger::Logger(Sink& sink_, const char* const prefix_, const char* const suffix_) noexcept :
+    std::ostream(nullptr),
+    _counters(new _impl::_counters[_ktz_impl_STATS_SHARDS]),
+    _sink(&sink_), _prefix(prefix_), _suffix(suffix_)
+  {
+    _self.reset(new _impl::_interceptor(this, "", ""));
+    rdbuf(_self.get());
+
+    _impl::_enlist(this);
+  }
+
+  Logger::Logger(const std::initializer_list<Sink*> sinks_, const char* const prefix_, const char* const suffix_) noexcept :
+    Logger(*new _impl::_fan_out(sinks_), prefix_, suffix_)
+  {
+    _owned_sink.reset(_sink);
+  }
+
+  Logger::~Logger() noexcept
+  {
+    _impl::_dismiss(this);
+    {
+      _ktz_impl_DECLARE_LOCK(_links_mtx);
+      _unlink_all();
+    }
+    _retired.clear(); // the Logger outlives every writer
+    _self.reset();
+    _async.reset();
+  }
+
+  void Logger::_flush_pending() noexcept
+  {
+    if (_async)
+    {
+      _async->wait();
+      return;
+    }
+
+    _ktz_impl_DECLARE_LOCK(_mutex);
+    _sink->flush();
+    _shard().flushes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto Logger::_shard() noexcept -> _impl::_counters&
+  {
+    static _ktz_impl_ATOMIC(unsigned) next = {0};
+    static _ktz_impl_THREADLOCAL unsigned shard = next++ % _ktz_impl_STATS_SHARDS;
+
+    return _counters[shard];
+  }
+
+  void Logger::measure(const bool enabled_) noexcept
+  {
+    _measuring.store(enabled_, std::memory_order_relaxed);
+  }
+
+  auto Logger::stats() const noexcept -> Stats
+  {
+    Stats stats = {};
+
+    for (size_t k = 0; k < _ktz_impl_STATS_SHARDS; ++k)
+    {
+      const _impl::_counters& shard = _counters[k];
+
+      stats.lines       += shard.lines.load(std::memory_order_relaxed);
+      stats.bytes       += shard.bytes.load(std::memory_order_relaxed);
+      stats.flushes     += shard.flushes.load(std::memory_order_relaxed);
+      stats.nanoseconds += shard.nanoseconds.load(std::memory_order_relaxed);
+
+      for (size_t bucket = 0; bucket < 32; ++bucket)
+      {
+        stats.latency[bucket] += shard.latency[bucket].load(std::memory_order_relaxed);
+      }
+    }
+
+    if (_async)
+    {
+      stats.lines   += _async->written_lines;
+      stats.bytes   += _async->written_bytes;
+      stats.flushes += _async->flushes;
+      stats.queued   = _async->queued();
+    }
+
+    return stats;
+  }
+
+  auto Logger::link(std::ostream& ostream_, const char* const prefix_, const char* const suffix_) noexcept -> Link
+  {
+    _ktz_impl_DECLARE_LOCK(_links_mtx);
+    _reclaim();
+
+    size_t slot = _links.size();
+
+    if (_free.empty())
+    {
+      _links.emplace_back();
+    }
+    else
+    {
+      slot = _free.back();
+      _free.pop_back();
+    }
+
+    _links[slot].reset(new _impl::_interceptor(this, ostream_, prefix_, suffix_));
+    ostream_.rdbuf(_links[slot].get()); // redirect towards the new interceptor
+
+    return {slot, _links[slot]->id()};
+  }
+
+  bool Logger::restore(const Link link_) noexcept
+  {
+    _ktz_impl_DECLARE_LOCK(_links_mtx);
+
+    if (link_.slot >= _links.size() or _links[link_.slot] == nullptr or _links[link_.slot]->id() != link_.id)
+    {
+      KTZ_WARNING("link was already restored.");
+      return false;
+    }
+
+    _unlink(link_.slot);
+    _reclaim();
+
+    return true;
+  }
 
   bool Logger::restore(std::ostream& ostream_) noexcept
   {
-    for (size_t k = _backups.size() - 1; k; --k)
+    _ktz_impl_DECLARE_LOCK(_links_mtx);
+
+    size_t latest = _links.size();
+
+    for (size_t k = 0; k < _links.size(); ++k)
+    {
+      if (_links[k] and _links[k]->_ostream == &ostream_
+        and (latest == _links.size() or _links[k]->id() > _links[latest]->id()))
+      {
+        latest = k;
+      }
+    }
+
+    if (latest == _links.size())
+    {
+      KTZ_WARNING("ostream was not in in backup list.");
+      return false;
+    }
+
+    _unlink(latest);
+    _reclaim();
+
+    return true;
+  }
+
+  void Logger::restore_all() noexcept
+  {
+    _ktz_impl_DECLARE_LOCK(_links_mtx);
+    _unlink_all();
+    _reclaim();
+  }
+
+  void Logger::_unlink_all() noexcept
+  {
+    std::vector<size_t> slots;
+
+    for (size_t k = 0; k < _links.size(); ++k)
+    {
+      if (_links[k]) slots.push_back(k);
+    }
+
+    // newest first, an ostream linked twice gets its original buffer back
+    std::sort(slots.begin(), slots.end(), [this](const size_t lhs_, const size_t rhs_){
+      return _links[lhs_]->id() > _links[rhs_]->id();
+    });
+
+    for (const size_t slot : slots)
+    {
+      _unlink(slot);
+    }
+  }
+
+  void Logger::_unlink(const size_t slot_) noexcept
+  {
+    // writers still inside the interceptor finish there, later ones are forwarded to the original buffer
+    _links[slot_]->restore();
+    _retired.push_back({_impl::_epoch::retire(), std::move(_links[slot_])});
+    _free.push_back(slot_);
+  }
+
+  void Logger::_reclaim() noexcept
+  {
+    if (_retired.empty()) _ktz_impl_LIKELY
+    {
+      return;
+    }
+
+    // only registered threads are accounted for, see register_thread
+    const unsigned long long oldest = _impl::_epoch::oldest();
+
+    _retired.erase(std::remove_if(_retired.begin(), _retired.end(), [&](const _retiree& retiree_){
+      return retiree_.epoch < oldest;
+    }), _retired.end());
+  }
+
+  void Logger::async(const unsigned capacity_, Backpressure policy_, Sink* const fallback_) noexcept
+  {
+# if defined(_ktz_impl_THREADSAFE)
+    if (policy_ == Backpressure::spill and fallback_ == nullptr)
+    {
+      KTZ_WARNING("spill requires a fallback sink, blocking instead.");
+      policy_ = Backpressure::block;
+    }
+
+    if (_async == nullptr)
+    {
+      _async.reset(new _impl::_async_writer(_sink, capacity_, policy_, fallback_));
+    }
+# else
+    static_cast<void>(capacity_);
+    static_cast<void>(policy_);
+    static_cast<void>(fallback_);
+# endif
+  }
+
+  auto Logger::dropped() const noexcept -> Dropped
+  {
+    if (_async == nullptr)
+    {
+      return {0, 0, 0, 0};
+    }
+
+    return {_async->dropped_lines, _async->dropped_bytes, _async->spilled_lines, _async->spilled_bytes};
+  }
+
+# if defined(_ktz_impl_POSIX)
+  MappedFile::MappedFile(const char* const path_, const size_t segment_) noexcept :
+    _path(path_), _segment(segment_), _index(_impl::_next_index(_path))
+  {
+    _open();
+  }
+
+  MappedFile::~MappedFile() noexcept
+  {
+    _close();
+  }
+
+  void MappedFile::write(const char* data_, size_t size_) noexcept
+  {
+    while (size_)
+    {
+      if (_map == nullptr) _ktz_impl_UNLIKELY
+      {
+        return; // the segment could not be created, lines are dropped
+      }
+
+      // keep lines whole, stop after the last one that fits, a line larger than a whole segment is split
+      size_t size = std::min(size_, _segment - _used);
+      if (size < size_) _ktz_impl_UNLIKELY
+      {
+        while (size and data_[size - 1] != '\n') --size;
+        if (size == 0) size = _used ? 0 : _segment;
+      }
+
+      std::memcpy(_map + _used, data_, size);
+
+      _used += size;
+      data_ += size;
+      size_ -= size;
+
+      if (_used == _segment or size_) _ktz_impl_UNLIKELY
+      {
+        _close();
+        ++_index;
+        _open();
+      }
+    }
+  }
+
+  void MappedFile::salvage(const char* const data_, const size_t size_) noexcept
+  {
+    if (_map and size_ <= _segment - _used)
+    {
+      std::memcpy(_map + _used, data_, size_);
+      _used += size_;
+    }
+  }
+
+  bool MappedFile::_open() noexcept
+  {
+    const std::string path = _path + '.' + std::to_string(_index);
+
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) _ktz_impl_UNLIKELY
+    {
+      KTZ_WARNING("could not open \"%s\".", path);
+      return false;
+    }
+
+    // reserve the blocks up front so that stores into the mapping cannot fail on a full disk
+#   if defined(__linux__)
+    const bool sized = ::posix_fallocate(_fd, 0, static_cast<off_t>(_segment)) == 0;
+#   else
+    const bool sized = ::ftruncate(_fd, static_cast<off_t>(_segment)) == 0;
+#   endif
+
+    void* const map = sized ? ::mmap(nullptr, _segment, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) _ktz_impl_UNLIKELY
+    {
+      KTZ_WARNING("could not map \"%s\".", path);
+      ::close(_fd);
+      _fd = -1;
+      return false;
+    }
+
+    _map  = static_cast<char*>(map);
+    _used = 0;
+
+    return true;
+  }
+
+  void MappedFile::_close() noexcept
+  {
+    if (_map)
+    {
+      ::munmap(_map, _segment);
+      _map = nullptr;
+    }
+
+    if (_fd >= 0)
+    {
+      if (::ftruncate(_fd, static_cast<off_t>(_used)) != 0) _ktz_impl_UNLIKELY
+      {
+        KTZ_WARNING("could not trim \"%s.%u\".", _path, _index);
+      }
+
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+# endif
+# if defined(_ktz_impl_POSIX) and defined(_ktz_impl_THREADSAFE)
+  RollingFile::RollingFile(const char* const path_, const size_t size_, const unsigned interval_, const unsigned keep_) noexcept :
+    _path(path_), _size(size_), _interval(std::chrono::seconds(interval_)), _keep(keep_),
+    _index(_impl::_next_index(_path)),
+    _deadline(interval_ ? _clock::now() + _interval : _clock::time_point::max()),
+    _buffer(new char[_ktz_impl_WRITE_LEN])
+  {
+    _fd = _prepare(_index);
+
+    _thread = std::thread([this]{
+      std::unique_lock<std::mutex> lock(_mutex);
+      unsigned prepared = _index;
+
+      while (true)
+      {
+        auto retired = std::move(_retired);
+        _retired.clear();
+        const bool missing = _next < 0;
+        const bool running = _running;
+
+        lock.unlock();
+
+        for (const auto& file : retired)
+        {
+          _retire(file.first, file.second);
+        }
+
+        // the destructor only stops the thread after the last rotation, nothing is retired past this point
+        if (not running)
+        {
+          return;
+        }
+
+        const int next = missing ? _prepare(prepared + 1) : -1;
+
+        lock.lock();
+
+        if (next >= 0)
+        {
+          _next = next;
+          ++prepared;
+        }
+
+        // a failed preparation is retried on the next rotation or a second later
+        _wakeup.wait_for(lock, std::chrono::seconds(1), [this]{ return not _running or not _retired.empty(); });
+      }
+    });
+  }
+
+  RollingFile::~RollingFile() noexcept
+  {
+    flush();
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _running = false;
+    }
+
+    _wakeup.notify_one();
+    _thread.join();
+
+    for (const auto& file : _retired)
+    {
+      _retire(file.first, file.second);
+    }
+
+    if (_fd >= 0)
+    {
+      ::fsync(_fd);
+      ::close(_fd);
+    }
+
+    _trim(_index);
+
+    // the preallocated file was never written to
+    if (_next >= 0)
+    {
+      ::close(_next);
+      ::unlink(_name(_index + 1).c_str());
+    }
+  }
+
+  void RollingFile::write(const char* const data_, const size_t size_) noexcept
+  {
+    if (_due()) _ktz_impl_UNLIKELY
+    {
+      _rotate();
+    }
+
+    _written += size_;
+
+    if (_buffered + size_ > _ktz_impl_WRITE_LEN) _ktz_impl_UNLIKELY
+    {
+      flush();
+
+      if (size_ > _ktz_impl_WRITE_LEN)
+      {
+        _impl::_write_all(_fd, data_, size_);
+        return;
+      }
+    }
+
+    std::memcpy(_buffer.get() + _buffered, data_, size_);
+    _buffered += size_;
+  }
+
+  void RollingFile::write_lines(const Line* const lines_, const size_t count_) noexcept
+  {
+    size_t size = 0;
+    for (size_t k = 0; k < count_; ++k)
+    {
+      size += lines_[k].size;
+    }
+
+    // rotation is checked line by line
+    if (_due() or _buffered + size <= _ktz_impl_WRITE_LEN)
+    {
+      Sink::write_lines(lines_, count_);
+      return;
+    }
+
+    _written += size;
+
+    flush();
+    _impl::_write_all(_fd, lines_, count_);
+  }
+
+  void RollingFile::flush() noexcept
+  {
+    // lines are dropped rather than retried forever
+    _impl::_write_all(_fd, _buffer.get(), _buffered);
+    _buffered = 0;
+  }
+
+  void RollingFile::salvage(const char* const data_, const size_t size_) noexcept
+  {
+    flush();
+    _impl::_write_all(_fd, data_, size_);
+  }
+
+  bool RollingFile::_due() const noexcept
+  {
+    return (_size and _written >= _size) or (_interval.count() and _clock::now() >= _deadline);
+  }
+
+  void RollingFile::_rotate() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // keep buffering into the current file rather than waiting for the background thread
+      if (_next < 0) _ktz_impl_UNLIKELY
+      {
+        return;
+      }
+    }
+
+    // only this thread takes _next, it is still there once the current file received its last lines
+    flush();
+
+    int next;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      next  = _next;
+      _next = -1;
+      _retired.emplace_back(_fd, _index);
+    }
+
+    _wakeup.notify_one();
+
+    _fd      = next;
+    _written = 0;
+    ++_index;
+
+    if (_interval.count())
+    {
+      _deadline = _clock::now() + _interval;
+    }
+  }
+
+  auto RollingFile::_prepare(const unsigned index_) noexcept -> int
+  {
+    const std::string path = _name(index_);
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) _ktz_impl_UNLIKELY
+    {
+      KTZ_WARNING("could not open \"%s\".", path);
+      return -1;
+    }
+
+#   if defined(__linux__) and defined(FALLOC_FL_KEEP_SIZE)
+    // reserve the blocks without changing the size, appends then never allocate
+    if (_size)
+    {
+      ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(_size));
+    }
+#   endif
+
+    return fd;
+  }
+
+  void RollingFile::_retire(const int fd_, const unsigned index_) noexcept
+  {
+    ::fsync(fd_);
+    ::close(fd_);
+
+    // the next file is already open
+    _trim(index_ + 1);
+  }
+
+  void RollingFile::_trim(const unsigned newest_) noexcept
+  {
+    // walk down to the first missing file, which also removes those an earlier run left past the retention
+    if (_keep and newest_ >= _keep)
+    {
+      for (unsigned index = newest_ - _keep; ::unlink(_name(index).c_str()) == 0 and index > 0; --index) {}
+    }
+  }
+
+  auto RollingFile::_name(const unsigned index_) const noexcept -> std::string
+  {
+    return _path + '.' + std::to_string(index_);
+  }
+# endif
+# if defined(_ktz_impl_POSIX)
+  RawFile::RawFile(const int fd_, const bool owned_) noexcept :
+    _fd(fd_), _owned(owned_), _buffer(_allocate())
+  {}
+
+  RawFile::RawFile(const char* const path_) noexcept :
+    RawFile(::open(path_, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644), true)
+  {
+    if (_fd < 0) _ktz_impl_UNLIKELY
+    {
+      KTZ_WARNING("could not open \"%s\".", path_);
+    }
+  }
+
+  RawFile::~RawFile() noexcept
+  {
+    flush();
+
+    if (_owned and _fd >= 0)
+    {
+      ::close(_fd);
+    }
+  }
+
+  void RawFile::write(const char* const data_, const size_t size_) noexcept
+  {
+    if (_buffer and _buffered + size_ <= _ktz_impl_WRITE_LEN) _ktz_impl_LIKELY
+    {
+      std::memcpy(_buffer.get() + _buffered, data_, size_);
+      _buffered += size_;
+      return;
+    }
+
+    // the buffer and the line leave together
+    const Line lines[] = {{_buffer.get(), _buffered}, {data_, size_}};
+    _impl::_write_all(_fd, lines, 2);
+    _buffered = 0;
+  }
+
+  void RawFile::write_lines(const Line* const lines_, const size_t count_) noexcept
+  {
+    size_t size = 0;
+    for (size_t k = 0; k < count_; ++k)
+    {
+      size += lines_[k].size;
+    }
+
+    if (_buffer and _buffered + size <= _ktz_impl_WRITE_LEN) _ktz_impl_LIKELY
+    {
+      Sink::write_lines(lines_, count_);
+      return;
+    }
+
+    flush();
+    _impl::_write_all(_fd, lines_, count_);
+  }
+
+  void RawFile::flush() noexcept
+  {
+    // lines are dropped rather than retried forever
+    _impl::_write_all(_fd, _buffer.get(), _buffered);
+    _buffered = 0;
+  }
+
+  void RawFile::salvage(const char* const data_, const size_t size_) noexcept
+  {
+    flush();
+    _impl::_write_all(_fd, data_, size_);
+  }
+
+  auto RawFile::_allocate() noexcept -> char*
+  {
+    void* buffer = nullptr;
+    if (::posix_memalign(&buffer, 4096, _ktz_impl_WRITE_LEN) != 0) _ktz_impl_UNLIKELY
+    {
+      KTZ_WARNING("could not allocate the write buffer, lines are written unbuffered.");
+      return nullptr;
+    }
+
+    return static_cast<char*>(buffer);
+  }
+# endif
+//----------------------------------------------------------------------------------------------------------------------
+  namespace _impl
+  {
+    inline // snapshot of the registered binary_log call sites
+    auto _binary_sites() noexcept -> std::vector<const _binary_site*>
+    {
+      _ktz_impl_DECLARE_LOCK(_sites_mtx());
+      return _binary_site::registry();
+    }
+
+    // binary_log records of every thread, 'consume(site, payload, size)' is called for each of them
+    template<typename C>
+    auto _drain_binary(std::ostream& ostream_, const C& consume_) noexcept -> size_t
     {
-      if (_backups[k]->_ostream == &ostream_)
+      std::vector<_binary_ring*> rings;
       {
-        _backups.erase(_backups.begin() + k);
-        return true;
+        _ktz_impl_DECLARE_LOCK(_rings_mtx());
+        for (const auto& ring : _binary_ring::rings()) rings.push_back(ring.get());
+      }
+
+      std::vector<const _binary_site*> sites;
+      size_t count = 0;
+
+      for (const auto ring : rings)
+      {
+        count += ring->drain([&](const uint32_t id_, const char* const payload_, const size_t size_) {
+          if (id_ > sites.size()) _ktz_impl_UNLIKELY
+          {
+            sites = _binary_sites();
+          }
+
+          if ((id_ != 0) and (id_ <= sites.size())) _ktz_impl_LIKELY
+          {
+            consume_(*sites[id_ - 1], payload_, size_);
+          }
+        });
+      }
+
+      size_t dropped = 0;
+      for (const auto ring : rings)
+      {
+        dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+      }
+
+      if (dropped) _ktz_impl_UNLIKELY
+      {
+        _text line;
+        line.append("log: binary_log: ");
+        _format(line, "%zu records dropped, increase KTZ_BINARY_LEN or drain more often", dropped);
+        line.push_back('\n');
+        ostream_.write(line.data(), static_cast<std::streamsize>(line.size()));
       }
+
+      return count;
     }
 
-    KTZ_WARNING("ostream was not in in backup list.");
+    template<typename T>
+    void _put(std::ostream& ostream_, const T& value_) noexcept
+    {
+      ostream_.write(reinterpret_cast<const char*>(&value_), sizeof(value_));
+    }
 
-    return false;
+    template<typename T>
+    bool _get(std::istream& istream_, T& value_) noexcept
+    {
+      return static_cast<bool>(istream_.read(reinterpret_cast<char*>(&value_), sizeof(value_)));
+    }
   }
 
-  void Logger::restore_all() noexcept
+  auto render_binary(std::ostream& text_) noexcept -> size_t
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_drain_mtx());
+
+    _impl::_text line;
+    const auto count = _impl::_drain_binary(text_,
+      [&](const _impl::_binary_site& site_, const char* const payload_, const size_t size_) {
+        line.clear();
+        _impl::_render_record(line, site_.caller, site_.format, payload_, size_, site_.kinds, site_.n_args);
+        text_.write(line.data(), static_cast<std::streamsize>(line.size()));
+      });
+
+    text_.flush();
+    return count;
+  }
+
+  // dump layout, in native byte order:
+  //   'S' u32 id, u32 line, u32 n_args, u8 kinds[n_args], format\0, caller\0, file\0
+  //   'R' u32 id, u32 size, u8 payload[size]
+  auto dump_binary(std::ostream& binary_) noexcept -> size_t
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_drain_mtx());
+
+    for (const auto site : _impl::_binary_sites())
+    {
+      binary_.put('S');
+      _impl::_put(binary_, site->id);
+      _impl::_put(binary_, static_cast<uint32_t>(site->line));
+      _impl::_put(binary_, static_cast<uint32_t>(site->n_args));
+      binary_.write(reinterpret_cast<const char*>(site->kinds), site->n_args);
+      binary_.write(site->format, static_cast<std::streamsize>(std::strlen(site->format) + 1));
+      binary_.write(site->caller, static_cast<std::streamsize>(std::strlen(site->caller) + 1));
+      binary_.write(site->file,   static_cast<std::streamsize>(std::strlen(site->file)   + 1));
+    }
+
+    const auto count = _impl::_drain_binary(_io::log,
+      [&](const _impl::_binary_site& site_, const char* const payload_, const size_t size_) {
+        binary_.put('R');
+        _impl::_put(binary_, site_.id);
+        _impl::_put(binary_, static_cast<uint32_t>(size_));
+        binary_.write(payload_, static_cast<std::streamsize>(size_));
+      });
+
+    binary_.flush();
+    return count;
+  }
+
+  auto decode_binary(std::istream& binary_, std::ostream& text_) noexcept -> size_t
+  {
+    struct _site
+    {
+      std::string       format;
+      std::string       caller;
+      std::vector<_impl::_kind> kinds;
+    };
+
+    std::vector<_site> sites;
+    std::string        payload;
+    _impl::_text       line;
+    size_t             count = 0;
+
+    for (char tag; binary_.get(tag);)
+    {
+      uint32_t id, size, n_args;
+
+      if (tag == 'S')
+      {
+        if (not (_impl::_get(binary_, id) and _impl::_get(binary_, size) and _impl::_get(binary_, n_args))) break;
+        if ((id == 0) or (n_args > _ktz_impl_MAX_ARGS)) break;
+
+        if (sites.size() < id) sites.resize(id);
+        _site& site = sites[id - 1];
+
+        site.kinds.resize(n_args);
+        binary_.read(reinterpret_cast<char*>(site.kinds.data()), n_args);
+
+        std::string file;
+        std::getline(binary_, site.format, '\0');
+        std::getline(binary_, site.caller, '\0');
+        std::getline(binary_, file,        '\0');
+      }
+      else if (tag == 'R')
+      {
+        if (not (_impl::_get(binary_, id) and _impl::_get(binary_, size))) break;
+
+        payload.resize(size);
+        if (not binary_.read(&payload[0], size)) break;
+        if ((id == 0) or (id > sites.size())) continue;
+
+        const _site& site = sites[id - 1];
+        line.clear();
+        _impl::_render_record(line, site.caller.c_str(), site.format.c_str(), payload.data(), payload.size(),
+          site.kinds.data(), static_cast<unsigned>(site.kinds.size()));
+        text_.write(line.data(), static_cast<std::streamsize>(line.size()));
+        ++count;
+      }
+      else _ktz_impl_UNLIKELY
+      {
+        break;
+      }
+    }
+
+    text_.flush();
+    return count;
+  }
+
+  void set_tracing(const bool enabled_) noexcept
+  {
+    _impl::_tracing().store(enabled_, std::memory_order_relaxed);
+  }
+
+  // complete ("X") events, one row per thread; each call drains the scopes recorded since the previous one
+  auto write_trace(std::ostream& json_) noexcept -> size_t
+  {
+    _ktz_impl_DECLARE_LOCK(_impl::_trace_mtx());
+
+    const auto   rings   = _impl::_span_ring::snapshot();
+    _impl::_text event;
+    size_t       count   = 0;
+    size_t       dropped = 0;
+
+    json_ << "{\"traceEvents\":[";
+
+    for (const auto ring : rings)
+    {
+      ring->drain([&](const _impl::_span_event& event_) {
+        event.clear();
+        event.append(count++ ? ",{\"name\":" : "{\"name\":");
+        _impl::_escape(event, event_.name, std::strlen(event_.name));
+        event.append(",\"ph\":\"X\",\"ts\":");
+        _impl::_append_microseconds(event, event_.begin);
+        event.append(",\"dur\":");
+        _impl::_append_microseconds(event, event_.end - event_.begin);
+        _impl::_format(event, ",\"pid\":1,\"tid\":%u,\"args\":{\"depth\":%u}}", ring->tid, event_.depth);
+        json_.write(event.data(), static_cast<std::streamsize>(event.size()));
+      });
+
+      dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    json_ << "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << dropped << "}}\n";
+    json_.flush();
+
+    return count;
+  }
+
+# if defined(_ktz_impl_THREADSAFE)
+  class BinaryWriter final
+  {
+  public:
+    inline // drain binary_log records every 'period' milliseconds, as text or for decode_binary
+    BinaryWriter(std::ostream& destination, bool binary = false, unsigned period = 10) noexcept;
+
+    inline // drain the remaining records
+    ~BinaryWriter() noexcept;
+
+  private:
+    std::ostream&           _destination;
+    const bool              _binary;
+    const unsigned          _period;
+    bool                    _running = true;
+    std::mutex              _mutex;
+    std::condition_variable _wakeup;
+    std::thread             _thread;
+  };
+
+  BinaryWriter::BinaryWriter(std::ostream& destination_, const bool binary_, const unsigned period_) noexcept :
+    _destination(destination_), _binary(binary_), _period(period_)
+  {
+    _thread = std::thread([this]{
+      std::unique_lock<std::mutex> lock(_mutex);
+
+      do
+      {
+        _binary ? dump_binary(_destination) : render_binary(_destination);
+      } while (not _wakeup.wait_for(lock, std::chrono::milliseconds(_period), [this]{ return not _running; }));
+
+      _binary ? dump_binary(_destination) : render_binary(_destination);
+    });
+  }
+
+  BinaryWriter::~BinaryWriter() noexcept
   {
-    _backups.clear();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _running = false;
+    }
+
+    _wakeup.notify_one();
+    _thread.join();
   }
+# endif
 // --Katagrafeas library: frontend struct and class member definitions--------------------------------------------------
   namespace _impl
   {
+    auto _interceptor::_live() noexcept -> std::vector<_interceptor*>&
+    {
+      static std::vector<_interceptor*>& live = *new std::vector<_interceptor*>;
+      return live;
+    }
+
+    auto _interceptor::_lines() noexcept -> _pending*
+    {
+      static _ktz_impl_THREADLOCAL _pending lines[_ktz_impl_PENDING_LINES];
+      return lines;
+    }
+
+    void _interceptor::_enroll() noexcept
+    {
+      _ktz_impl_DECLARE_LOCK(_interceptors_mtx());
+      _live().push_back(this);
+    }
+
+    auto _interceptor::_find() noexcept -> _pending*
+    {
+      _pending* const lines = _lines();
+
+      for (size_t k = 0; k < _ktz_impl_PENDING_LINES; ++k)
+      {
+        if (lines[k].id == _id) _ktz_impl_LIKELY
+        {
+          return &lines[k];
+        }
+      }
+
+      return nullptr;
+    }
+
+    auto _interceptor::_line() noexcept -> _pending&
+    {
+      static _ktz_impl_THREADLOCAL unsigned victim = 0;
+
+      if (_pending* const line = _find()) _ktz_impl_LIKELY
+      {
+        return *line;
+      }
+
+      // the evicted line belongs to a stream this thread stopped writing to
+      _pending& line = _lines()[victim++ % _ktz_impl_PENDING_LINES];
+
+      if (not line.text.empty()) _ktz_impl_UNLIKELY
+      {
+        _evict(line);
+      }
+
+      line.owner = this;
+      line.id    = _id;
+      line.open  = false;
+      line.text.clear();
+      line.text.reserve(_ktz_impl_BUF_LEN);
+
+      return line;
+    }
+
+    void _interceptor::_evict(_pending& line_) noexcept
+    {
+      // the owner may have been reclaimed since, its Logger is alive as long as it is
+      _ktz_impl_DECLARE_LOCK(_interceptors_mtx());
+
+      for (const _interceptor* const live : _live())
+      {
+        if (live == line_.owner and live->_id == line_.id)
+        {
+          line_.owner->_commit(line_.text);
+          return;
+        }
+      }
+    }
+
+    void _interceptor::_commit(std::string& line_) noexcept
+    {
+      _suffix.render(line_);
+      _stream->_suffix.render(line_);
+      line_ += '\n';
+
+      _write(line_, 1);
+
+      line_.clear();
+    }
+
+    void _interceptor::_write(const std::string& text_, const unsigned long long lines_) noexcept
+    {
+      if (_stream->_async) _ktz_impl_UNLIKELY
+      {
+        _stream->_async->push(text_.data(), text_.size()); // the writer counts what reaches the sink
+        return;
+      }
+
+      {
+        _ktz_impl_DECLARE_LOCK(_stream->_mutex);
+        _stream->_sink->write(text_.data(), text_.size());
+      }
+
+      _counters& shard = _stream->_shard();
+      shard.lines.fetch_add(lines_, std::memory_order_relaxed);
+      shard.bytes.fetch_add(text_.size(), std::memory_order_relaxed);
+    }
+
     auto _interceptor::overflow(const int_type character_) -> int_type
     {
-      if (character_ == '\n') _ktz_impl_UNLIKELY
+      if (traits_type::eq_int_type(character_, traits_type::eof())) _ktz_impl_UNLIKELY
+      {
+        return traits_type::not_eof(character_);
+      }
+
+      const char_type character = traits_type::to_char_type(character_);
+      xsputn(&character, 1);
+
+      return character_;
+    }
+
+    auto _interceptor::xsputn(const char_type* data_, const std::streamsize size_) -> std::streamsize
+    {
+      const _epoch::section section;
+
+      if (_restored.load(std::memory_order_acquire)) _ktz_impl_UNLIKELY
+      {
+        std::streambuf* const backup = _buffer_backup.load(std::memory_order_acquire);
+        return backup ? backup->sputn(data_, size_) : 0;
+      }
+
+      const unsigned long long begin   = _stream->_measuring.load(std::memory_order_relaxed) ? _steady_ns() : 0;
+      const char_type* const   end     = data_ + size_;
+      _pending&                pending = _line();
+      std::string&             line    = pending.text;
+
+      while (data_ != end)
       {
-        _stream->_underlying_ostream << _impl::_format_string(_suffix);
-        _stream->_underlying_ostream << _impl::_format_string(_stream->_suffix);
+        const auto newline = static_cast<const char*>(std::memchr(data_, '\n', static_cast<size_t>(end - data_)));
+        const auto line_end = newline ? newline : end;
+
+        if (line.empty() and not pending.open and (data_ != line_end)) _ktz_impl_UNLIKELY
+        {
+          _stream->_prefix.render(line);
+          _prefix.render(line);
+        }
+
+        line.append(data_, static_cast<size_t>(line_end - data_));
+
+        if (newline == nullptr) break;
+
+        _commit(line);
+        pending.open = false;
+
+        data_ = newline + 1;
       }
-      else if (_stream->_prepend_flag) _ktz_impl_UNLIKELY
+
+      if (begin) _ktz_impl_UNLIKELY
       {
-        _stream->_underlying_ostream << _impl::_format_string(_stream->_prefix);
-        _stream->_underlying_ostream << _impl::_format_string(_prefix);
-        _stream->_prepend_flag = false;
+        _stream->_shard().measured(begin);
       }
 
-      return _stream->_buffer->sputc(static_cast<char>(character_));
+      return size_;
     }
 
     auto _interceptor::sync() -> int
     {
-      _stream->_prepend_flag = true;
-      return 0;
+      const _epoch::section section;
+
+      if (_restored.load(std::memory_order_acquire)) _ktz_impl_UNLIKELY
+      {
+        std::streambuf* const backup = _buffer_backup.load(std::memory_order_acquire);
+        return backup ? backup->pubsync() : 0;
+      }
+
+      const unsigned long long begin = _stream->_measuring.load(std::memory_order_relaxed) ? _steady_ns() : 0;
+
+      // write what the calling thread has of its line so far, the rest follows without prefixes
+      _pending* const pending = _find();
+
+      if (pending and not pending->text.empty()) _ktz_impl_UNLIKELY
+      {
+        _write(pending->text, 0);
+        pending->text.clear();
+        pending->open = true;
+      }
+
+      if (not _stream->_async) _ktz_impl_LIKELY
+      {
+        _ktz_impl_DECLARE_LOCK(_stream->_mutex);
+        _stream->_sink->flush();
+        _stream->_shard().flushes.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      if (begin) _ktz_impl_UNLIKELY
+      {
+        _stream->_shard().measured(begin);
+      }
+
+      return 0; // the background writer flushes after each batch
     }
   }
 }